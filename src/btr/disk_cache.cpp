@@ -0,0 +1,378 @@
+#include "./disk_cache.hpp"
+
+#include "./file.hpp"
+#include "./paths.hpp"
+
+#include <neo/assert.hpp>
+#include <neo/platform.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <span>
+#include <vector>
+
+using namespace btr;
+namespace fs = std::filesystem;
+
+namespace {
+
+/**
+ * A minimal SHA-256 implementation (FIPS 180-4), used only to compute cache keys.
+ */
+class sha256 {
+    static constexpr std::array<std::uint32_t, 64> round_constants = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4,
+        0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe,
+        0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f,
+        0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+        0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc,
+        0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+        0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116,
+        0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7,
+        0xc67178f2,
+    };
+
+    std::array<std::uint32_t, 8> _state = {
+        0x6a09e667,
+        0xbb67ae85,
+        0x3c6ef372,
+        0xa54ff53a,
+        0x510e527f,
+        0x9b05688c,
+        0x1f83d9ab,
+        0x5be0cd19,
+    };
+
+    std::array<std::uint8_t, 64> _block{};
+    std::size_t                  _block_len = 0;
+    std::uint64_t                _total_len = 0;
+
+    static constexpr std::uint32_t rotr(std::uint32_t x, int n) noexcept {
+        return (x >> n) | (x << (32 - n));
+    }
+
+    void _compress() noexcept {
+        std::array<std::uint32_t, 64> w;
+        for (auto i = 0u; i < 16; ++i) {
+            w[i] = (std::uint32_t(_block[i * 4]) << 24) | (std::uint32_t(_block[i * 4 + 1]) << 16)
+                | (std::uint32_t(_block[i * 4 + 2]) << 8) | std::uint32_t(_block[i * 4 + 3]);
+        }
+        for (auto i = 16u; i < 64; ++i) {
+            auto s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            auto s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i]    = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        auto [a, b, c, d, e, f, g, h] = _state;
+        for (auto i = 0u; i < 64; ++i) {
+            auto s1    = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+            auto ch    = (e & f) ^ (~e & g);
+            auto temp1 = h + s1 + ch + round_constants[i] + w[i];
+            auto s0    = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+            auto maj   = (a & b) ^ (a & c) ^ (b & c);
+            auto temp2 = s0 + maj;
+            h          = g;
+            g          = f;
+            f          = e;
+            e          = d + temp1;
+            d          = c;
+            c          = b;
+            b          = a;
+            a          = temp1 + temp2;
+        }
+        _state[0] += a;
+        _state[1] += b;
+        _state[2] += c;
+        _state[3] += d;
+        _state[4] += e;
+        _state[5] += f;
+        _state[6] += g;
+        _state[7] += h;
+    }
+
+    void _push(std::uint8_t byte) noexcept {
+        _block[_block_len++] = byte;
+        if (_block_len == _block.size()) {
+            _compress();
+            _block_len = 0;
+        }
+    }
+
+public:
+    void update(const_buffer data) noexcept {
+        auto ptr = reinterpret_cast<const std::uint8_t*>(data.data());
+        for (auto i = 0u; i < data.size(); ++i) {
+            _push(ptr[i]);
+        }
+        _total_len += data.size();
+    }
+
+    std::array<std::uint8_t, 32> finish() noexcept {
+        const std::uint64_t bit_len = _total_len * 8;
+        _push(0x80);
+        while (_block_len != 56) {
+            _push(0);
+        }
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            _push(static_cast<std::uint8_t>(bit_len >> shift));
+        }
+        std::array<std::uint8_t, 32> digest;
+        for (auto i = 0u; i < 8; ++i) {
+            digest[i * 4]     = static_cast<std::uint8_t>(_state[i] >> 24);
+            digest[i * 4 + 1] = static_cast<std::uint8_t>(_state[i] >> 16);
+            digest[i * 4 + 2] = static_cast<std::uint8_t>(_state[i] >> 8);
+            digest[i * 4 + 3] = static_cast<std::uint8_t>(_state[i]);
+        }
+        return digest;
+    }
+};
+
+constexpr char hex_digits[] = "0123456789abcdef";
+
+void check_key(std::string_view key) {
+    neo_assert(expects,
+               key.size() >= 2
+                   && std::ranges::all_of(key,
+                                          [](char c) {
+                                              return (c >= '0' && c <= '9')
+                                                  || (c >= 'a' && c <= 'f');
+                                          }),
+               "Invalid disk_cache key. Keys must be at least two lowercase hexadecimal digits",
+               key);
+}
+
+/// Determine whether a filename in the cache is a temporary file from file::write_atomic(). Entries
+/// never contain a '.'
+bool is_temp_name(const fs::path& filename) {
+    return filename.string().find('.') != std::string::npos;
+}
+
+/**
+ * Remove an entry from the cache directory. Returns `true` if the entry was removed.
+ *
+ * On Windows, a file that is mapped into memory cannot be deleted or replaced, but it can be
+ * renamed. So the entry is first moved aside to a temporary name. If it cannot be deleted yet,
+ * trim() deletes it later with the abandoned temporary files.
+ */
+bool remove_entry(const fs::path& entry) {
+    std::error_code ec;
+    if (!neo::os_is_windows) {
+        return fs::remove(entry, ec);
+    }
+    thread_local std::mt19937_64 rng{std::random_device{}()};
+    auto                         n    = rng();
+    auto                         name = entry.filename().string() + ".removed-";
+    for (auto i = 0; i < 16; ++i) {
+        name.push_back(hex_digits[n & 0xf]);
+        n >>= 4;
+    }
+    const auto aside = entry.parent_path() / name;
+    fs::rename(entry, aside, ec);
+    if (ec) {
+        return false;
+    }
+    fs::remove(aside, ec);
+    return true;
+}
+
+/// Temporary files older than this were abandoned by a writer that crashed, and are removed by trim
+constexpr auto abandoned_temp_age = std::chrono::hours{1};
+
+/**
+ * A trim removes entries until the cache is within 90% of its maximum size, so that the stores that
+ * follow do not each need another trim.
+ */
+constexpr std::uint64_t trim_target(std::uint64_t max_size) noexcept {
+    return max_size - max_size / 10;
+}
+
+}  // namespace
+
+class disk_cache::impl {
+public:
+    const fs::path      root;
+    const std::uint64_t max_size;
+
+    /// Serializes trims within this process
+    std::mutex trim_mtx;
+    /// The total size of the entries as of the last trim(), adjusted for the entries stored and
+    /// removed since
+    std::atomic<std::uint64_t> size{0};
+
+    impl(fs::path root_, std::uint64_t max_size_)
+        : root(std::move(root_))
+        , max_size(max_size_) {}
+
+    /// Account for entries that have been added and removed by this process
+    void adjust_size(std::uint64_t added, std::uint64_t removed) noexcept {
+        // Entries stored by other processes are not counted, so don't wrap below zero
+        auto cur = size.load();
+        while (!size.compare_exchange_weak(cur, cur + added - (std::min)(cur + added, removed))) {}
+    }
+
+    fs::path entry_path(std::string_view key) const {
+        check_key(key);
+        return root / key.substr(0, 2) / key;
+    }
+
+    void trim() {
+        struct found_entry {
+            fs::file_time_type mtime;
+            std::uint64_t      size;
+            fs::path           path;
+        };
+
+        std::unique_lock         lk{trim_mtx};
+        std::vector<found_entry> entries;
+        std::uint64_t            total = 0;
+        const auto               now   = fs::file_time_type::clock::now();
+        std::error_code          ec;
+        for (auto it = fs::recursive_directory_iterator{root, ec};
+             it != fs::recursive_directory_iterator{};
+             it.increment(ec)) {
+            if (ec) {
+                // Another process may have removed a shard directory while we were iterating
+                break;
+            }
+            if (!it->is_regular_file(ec)) {
+                continue;
+            }
+            auto mtime = it->last_write_time(ec);
+            auto fsize = it->file_size(ec);
+            if (ec) {
+                // Removed by another process
+                continue;
+            }
+            if (is_temp_name(it->path().filename())) {
+                if (now - mtime > abandoned_temp_age) {
+                    fs::remove(it->path(), ec);
+                }
+                continue;
+            }
+            total += fsize;
+            entries.push_back({mtime, fsize, it->path()});
+        }
+
+        if (total > max_size) {
+            const auto target = trim_target(max_size);
+            std::ranges::sort(entries, std::less<>{}, &found_entry::mtime);
+            for (auto& ent : entries) {
+                if (total <= target) {
+                    break;
+                }
+                // If the entry cannot be removed, it still counts. An entry that was already
+                // removed by another process does not.
+                if (remove_entry(ent.path) || !fs::exists(ent.path, ec)) {
+                    total -= ent.size;
+                }
+            }
+        }
+        size.store(total);
+    }
+};
+
+btr::disk_cache::disk_cache(fs::path root, std::uint64_t max_size)
+    : _impl(std::make_shared<impl>(std::move(root), max_size)) {
+    fs::create_directories(_impl->root);
+    _impl->trim();
+}
+
+disk_cache btr::disk_cache::for_user(u8view name, std::uint64_t max_size) {
+    return disk_cache(user_cache_dir() / fs::path(name.u8string_view()), max_size);
+}
+
+std::string btr::disk_cache::make_key(const_buffer data) {
+    sha256 hash;
+    hash.update(data);
+    auto        digest = hash.finish();
+    std::string key;
+    key.reserve(digest.size() * 2);
+    for (auto byte : digest) {
+        key.push_back(hex_digits[byte >> 4]);
+        key.push_back(hex_digits[byte & 0xf]);
+    }
+    return key;
+}
+
+const fs::path& btr::disk_cache::root() const noexcept { return _impl->root; }
+
+std::uint64_t btr::disk_cache::max_size() const noexcept { return _impl->max_size; }
+
+std::uint64_t btr::disk_cache::size_bytes() const { return _impl->size.load(); }
+
+void btr::disk_cache::trim() { _impl->trim(); }
+
+void btr::disk_cache::_store(std::string_view key, const_buffer content, bool replace) {
+    const auto      dest = _impl->entry_path(key);
+    std::error_code ec;
+    if (!replace && fs::exists(dest, ec)) {
+        // Content-addressed and already present: Just mark it as used
+        fs::last_write_time(dest, fs::file_time_type::clock::now(), ec);
+        return;
+    }
+
+    // The size of the entry being replaced, if any
+    std::uint64_t old_size = 0;
+    if (replace) {
+        old_size = fs::file_size(dest, ec);
+        if (ec) {
+            old_size = 0;
+        }
+    }
+
+    if (replace && neo::os_is_windows) {
+        // A mapped entry cannot be replaced on Windows, but it can be moved out of the way
+        remove_entry(dest);
+    }
+
+    fs::create_directories(dest.parent_path());
+    try {
+        // Entries can be regenerated, so they are not worth the cost of a sync
+        file::write_atomic(dest,
+                           std::span<const std::byte>(content.data(), content.size()),
+                           {.sync_file = false});
+    } catch (const file_error&) {
+        if (!replace && fs::exists(dest, ec)) {
+            // Another writer published the same content before us (and it may be held open, which
+            // prevents replacing it on some platforms).
+            return;
+        }
+        throw;
+    }
+
+    _impl->adjust_size(content.size(), old_size);
+    if (_impl->size.load() > _impl->max_size) {
+        trim();
+    }
+}
+
+std::optional<mapped_file> btr::disk_cache::load(std::string_view key) const {
+    const auto path = _impl->entry_path(key);
+    try {
+        auto mapped = mapped_file::open(path);
+        // Access times are unreliable, so record the use in the modification time
+        std::error_code ec;
+        fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+        return mapped;
+    } catch (const file_not_found_error&) {
+        return std::nullopt;
+    }
+}
+
+bool btr::disk_cache::contains(std::string_view key) const {
+    std::error_code ec;
+    return fs::is_regular_file(_impl->entry_path(key), ec);
+}
+
+void btr::disk_cache::remove(std::string_view key) {
+    std::error_code ec;
+    const auto      path  = _impl->entry_path(key);
+    const auto      fsize = fs::file_size(path, ec);
+    if (!ec && remove_entry(path)) {
+        _impl->adjust_size(0, fsize);
+    }
+}
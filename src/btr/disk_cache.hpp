@@ -0,0 +1,126 @@
+#pragma once
+
+#include "./mapped_file.hpp"
+#include "./trivial_range.hpp"
+#include "./u8view.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace btr {
+
+/**
+ * @brief A size-bounded cache of files in a directory on disk.
+ *
+ * Each entry is a single file, named by its key. Keys are strings of lowercase hexadecimal digits,
+ * usually obtained from make_key(): An entry can be keyed by a hash of the inputs that produced it,
+ * or stored by its own content with store(). Entries are spread across 256 subdirectories by the
+ * first two digits of their key, so that no directory grows too large.
+ *
+ * Entries are published atomically: They are written to a temporary file which is then renamed
+ * into place, so a reader (in this or any other process) never observes a partially written
+ * entry. Entries are read with a memory mapping.
+ *
+ * When the total size of the entries exceeds the maximum size of the cache, the least-recently
+ * used entries are removed until it is within 90% of the maximum size. Because file access times
+ * are often not recorded (e.g. with the `noatime` and `relatime` mount options), the modification
+ * time of an entry is updated whenever it is loaded, and is used as its access time.
+ *
+ * A disk_cache may be used from multiple threads simultaneously, and multiple processes may share
+ * a cache directory. Copies of a disk_cache refer to the same underlying cache.
+ */
+class disk_cache {
+    class impl;
+    std::shared_ptr<impl> _impl;
+
+    void _store(std::string_view key, const_buffer content, bool replace);
+
+public:
+    /// The maximum size of a cache, unless another is specified: 1 GiB
+    static constexpr std::uint64_t default_max_size = 1024ull * 1024 * 1024;
+
+    /**
+     * @brief Open a cache in the given directory. The directory is created if it does not exist.
+     *
+     * @param root The directory that holds the cache entries
+     * @param max_size The maximum number of bytes of entries to retain
+     */
+    explicit disk_cache(std::filesystem::path root, std::uint64_t max_size = default_max_size);
+
+    /**
+     * @brief Open a cache in the subdirectory of btr::user_cache_dir() with the given name
+     */
+    [[nodiscard]] static disk_cache for_user(u8view        name,
+                                             std::uint64_t max_size = default_max_size);
+
+    /**
+     * @brief Compute a key from the given data. The key is the hex-encoded SHA-256 hash of the
+     * data.
+     */
+    [[nodiscard]] static std::string make_key(const_buffer data);
+
+    /// @copydoc make_key(const_buffer)
+    [[nodiscard]] static std::string make_key(trivial_range auto&& data) {
+        return make_key(const_buffer(data));
+    }
+
+    /// Get the directory that holds the cache
+    [[nodiscard]] const std::filesystem::path& root() const noexcept;
+
+    /// Get the maximum number of bytes of entries that the cache will retain
+    [[nodiscard]] std::uint64_t max_size() const noexcept;
+
+    /**
+     * @brief Store an entry in the cache, replacing any existing entry with the same key.
+     *
+     * @throws file_error if we are unable to write the entry
+     */
+    void store(std::string_view key, trivial_range auto&& content) {
+        _store(key, const_buffer(content), true);
+    }
+
+    /**
+     * @brief Store an entry keyed by its own content, i.e. by make_key(content).
+     *
+     * If an entry with the same content is already present, it is not written again.
+     *
+     * @return std::string The key of the entry
+     */
+    std::string store(trivial_range auto&& content) {
+        auto key = make_key(content);
+        _store(key, const_buffer(content), false);
+        return key;
+    }
+
+    /**
+     * @brief Load the entry with the given key, and mark it as recently used.
+     *
+     * @return std::optional<mapped_file> A mapping of the entry, or nullopt if there is no such
+     *      entry. The mapping remains valid even if the entry is subsequently replaced or evicted.
+     */
+    [[nodiscard]] std::optional<mapped_file> load(std::string_view key) const;
+
+    /// Determine whether an entry with the given key is present, without marking it as used
+    [[nodiscard]] bool contains(std::string_view key) const;
+
+    /// Remove the entry with the given key, if it is present
+    void remove(std::string_view key);
+
+    /**
+     * @brief If the cache exceeds its maximum size, remove least-recently used entries until it is
+     * within 90% of its maximum size.
+     *
+     * This is done automatically when storing an entry causes the cache to exceed its maximum
+     * size, so it is only required if the cache directory is shared with other processes.
+     */
+    void trim();
+
+    /// Get the total number of bytes of the entries in the cache, as of the last trim()
+    [[nodiscard]] std::uint64_t size_bytes() const;
+};
+
+}  // namespace btr
@@ -0,0 +1,103 @@
+#include <btr/disk_cache.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <string>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+/// A fresh directory for a test, removed when the test ends
+struct test_dir {
+    fs::path path;
+
+    explicit test_dir(std::string_view name)
+        : path(fs::current_path() / "_test" / name) {
+        fs::remove_all(path);
+    }
+
+    ~test_dir() {
+        std::error_code ec;
+        fs::remove_all(path, ec);
+    }
+};
+
+}  // namespace
+
+TEST_CASE("Compute cache keys") {
+    CHECK(btr::disk_cache::make_key(std::string_view(""))
+          == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    CHECK(btr::disk_cache::make_key(std::string_view("abc"))
+          == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    // Spans more than one block
+    CHECK(btr::disk_cache::make_key(std::string(1000, 'a'))
+          == "41edece42d63e8d9bf515a9ba6932e1c20cbc9f5a5d134645adb5db1b9737ea3");
+}
+
+TEST_CASE("Store and load cache entries") {
+    test_dir        dir{"store-load"};
+    btr::disk_cache cache{dir.path};
+    CHECK(cache.size_bytes() == 0);
+
+    auto key = cache.store(std::string_view("I am some content"));
+    CHECK(key == btr::disk_cache::make_key(std::string_view("I am some content")));
+    CHECK(cache.contains(key));
+    CHECK(fs::is_regular_file(cache.root() / key.substr(0, 2) / key));
+    CHECK(cache.size_bytes() == 17);
+
+    auto loaded = cache.load(key);
+    REQUIRE(loaded);
+    CHECK(loaded->string_view() == "I am some content");
+
+    // Entries are replaced in place, and existing mappings remain valid
+    cache.store(key, std::string_view("Other content"));
+    CHECK(loaded->string_view() == "I am some content");
+    CHECK(cache.load(key)->string_view() == "Other content");
+    // The replaced entry no longer counts
+    CHECK(cache.size_bytes() == 13);
+
+    cache.remove(key);
+    CHECK_FALSE(cache.contains(key));
+    CHECK_FALSE(cache.load(key));
+    CHECK(loaded->string_view() == "I am some content");
+
+    // Empty entries are allowed
+    key = cache.store(std::string_view(""));
+    REQUIRE(cache.load(key));
+    CHECK(cache.load(key)->empty());
+}
+
+TEST_CASE("Evict least-recently used cache entries") {
+    test_dir        dir{"evict"};
+    btr::disk_cache cache{dir.path, 30};
+    CHECK(cache.max_size() == 30);
+
+    auto first  = cache.store(std::string(10, 'a'));
+    auto second = cache.store(std::string(10, 'b'));
+    auto third  = cache.store(std::string(10, 'c'));
+    CHECK(cache.size_bytes() == 30);
+
+    // Mark the first entry as most-recently used
+    fs::last_write_time(cache.root() / second.substr(0, 2) / second,
+                        fs::file_time_type::clock::now() - std::chrono::hours{2});
+    fs::last_write_time(cache.root() / third.substr(0, 2) / third,
+                        fs::file_time_type::clock::now() - std::chrono::hours{1});
+    CHECK(cache.load(first));
+
+    // Storing a fourth entry exceeds the maximum size, and evicts the oldest until the cache is
+    // within 90% of its maximum size
+    auto fourth = cache.store(std::string(10, 'd'));
+    CHECK(cache.size_bytes() == 20);
+    CHECK(cache.contains(first));
+    CHECK_FALSE(cache.contains(second));
+    CHECK_FALSE(cache.contains(third));
+    CHECK(cache.contains(fourth));
+
+    // Reopening the cache finds the existing entries
+    btr::disk_cache reopened{cache.root(), 30};
+    CHECK(reopened.size_bytes() == 20);
+    CHECK(reopened.contains(first));
+    CHECK(reopened.contains(fourth));
+}
@@ -1,73 +1,294 @@
 #include "./environ.hpp"
 
+#include "./syserror.hpp"
 #include "./utf.hpp"
 
+#include <neo/assert.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+#if _WIN32
+#include <windows.h>
+#elif __APPLE__
+#include <crt_externs.h>
+#define environ (*::_NSGetEnviron())
+#else
+#include <unistd.h>
+#endif
+
 using namespace btr;
 
+namespace {
+
 #if !_WIN32
 
-std::optional<std::string> btr::getenv(u8view key) noexcept {
-    auto ptr = std::getenv(key.data());
-    if (ptr) {
-        return std::make_optional(std::string(ptr));
-    } else {
-        return std::nullopt;
+/// Copy the environment of the process as a sequence of null-terminated "name=value" strings
+std::string read_environment_block() {
+    std::string block;
+    for (auto ptr = environ; ptr && *ptr; ++ptr) {
+        block.append(*ptr);
+        block.push_back('\0');
     }
+    return block;
 }
 
-std::optional<std::u8string> btr::u8getenv(u8view key) noexcept {
-    auto ptr = std::getenv(key.data());
-    if (ptr) {
-        return std::u8string(u8view(ptr));
-    } else {
+/// Read a variable from the environment of the process
+std::optional<btr::u8string> get_process_env(u8view key) {
+    auto ptr = std::getenv(btr::u8string{key}.c_str());
+    if (!ptr) {
         return std::nullopt;
     }
+    return btr::u8string(u8view(std::string_view(ptr)));
 }
 
-#else
+/// Modify the environment of the process. If `value` is null, the variable is removed.
+void set_process_env(u8view name, const u8view* value) {
+    const btr::u8string name_str{name};
+    const int           rc = value ? ::setenv(name_str.c_str(), btr::u8string{*value}.c_str(), 1)
+                                   : ::unsetenv(name_str.c_str());
+    if (rc != 0) {
+        throw_current_error("Failed to modify the process environment");
+    }
+}
 
-#include <windows.h>
+#else
 
-namespace {
+/// Copy the environment of the process as a sequence of null-terminated "name=value" strings
+std::string read_environment_block() {
+    auto env = ::GetEnvironmentStringsW();
+    if (!env) {
+        return {};
+    }
+    // The block is terminated by an empty string
+    const wchar_t* end = env;
+    while (*end) {
+        end += std::wcslen(end) + 1;
+    }
+    auto block = btr::u8_as_char_encode(std::wstring_view(env, end));
+    ::FreeEnvironmentStringsW(env);
+    return block;
+}
 
-std::optional<std::wstring> getenv_wstr(std::wstring const& varname, std::size_t size_hint = 256) {
+/// Read a variable from the environment of the process
+std::optional<btr::u8string> get_process_env(u8view key) {
+    const auto   wide_key = btr::wide_encode(key.u8string_view());
     std::wstring ret;
-    ret.resize(size_hint);
+    ret.resize(256);
     while (true) {
-        auto real_len
-            = ::GetEnvironmentVariableW(varname.data(), ret.data(), static_cast<DWORD>(ret.size()));
+        auto real_len = ::GetEnvironmentVariableW(wide_key.data(),
+                                                  ret.data(),
+                                                  static_cast<DWORD>(ret.size()));
         if (real_len == 0 && ::GetLastError() == ERROR_ENVVAR_NOT_FOUND) {
             // Environment variable is not defined
             return std::nullopt;
         } else if (real_len > ret.size()) {
             // Try again, with a larger buffer
             ret.resize(real_len);
-            continue;
         } else {
-            // Got it!
             ret.resize(real_len);
-            return ret;
+            return btr::u8string(u8view(btr::u8encode(ret)));
         }
     }
-    return std::make_optional(std::move(ret));
 }
 
+/// Modify the environment of the process. If `value` is null, the variable is removed.
+void set_process_env(u8view name, const u8view* value) {
+    const auto wide_name  = btr::wide_encode(name.u8string_view());
+    const auto wide_value = value ? btr::wide_encode(value->u8string_view()) : std::wstring();
+    const BOOL okay
+        = ::SetEnvironmentVariableW(wide_name.c_str(), value ? wide_value.c_str() : nullptr);
+    if (!okay && (value || ::GetLastError() != ERROR_ENVVAR_NOT_FOUND)) {
+        throw_current_error("Failed to modify the process environment");
+    }
+}
+
+#endif
+
+/// Environment variable names are case-insensitive on Windows
+constexpr char fold_name_char(char c) noexcept {
+#if _WIN32
+    return (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c;
+#else
+    return c;
+#endif
+}
+
+struct env_name_hash {
+    std::size_t operator()(std::string_view name) const noexcept {
+        // FNV-1a
+        std::size_t h = 14695981039346656037ull;
+        for (char c : name) {
+            h = (h ^ static_cast<unsigned char>(fold_name_char(c))) * 1099511628211ull;
+        }
+        return h;
+    }
+};
+
+struct env_name_equal {
+    bool operator()(std::string_view a, std::string_view b) const noexcept {
+        return std::ranges::equal(a, b, {}, fold_name_char, fold_name_char);
+    }
+};
+
 }  // namespace
 
-std::optional<std::string> btr::getenv(u8view key) noexcept {
-    std::optional<std::wstring> val = getenv_wstr(btr::wide_encode(key.u8string_view()));
-    if (!val) {
-        return std::nullopt;
+class btr::environment_snapshot::impl {
+    std::string                       _block;
+    std::vector<environment_variable> _vars;
+    std::vector<const char*>          _envp;
+    std::unordered_map<std::string_view, std::size_t, env_name_hash, env_name_equal> _index;
+
+public:
+    explicit impl(std::string block)
+        : _block(std::move(block)) {
+        std::string_view tail = _block;
+        while (!tail.empty()) {
+            const auto entry = tail.substr(0, tail.find('\0'));
+            tail.remove_prefix((std::min)(entry.size() + 1, tail.size()));
+            // Start the search at the second character: Windows has hidden variables whose names
+            // begin with an equal sign.
+            const auto eq = entry.find('=', 1);
+            if (eq == entry.npos) {
+                continue;
+            }
+            const auto name = entry.substr(0, eq);
+            // The first of any duplicate names is the one seen by getenv()
+            if (_index.emplace(name, _vars.size()).second) {
+                _vars.push_back({name, entry.substr(eq + 1)});
+                _envp.push_back(entry.data());
+            }
+        }
+        _envp.push_back(nullptr);
+    }
+
+    std::optional<u8view> get(std::string_view name) const noexcept {
+        auto found = _index.find(name);
+        if (found == _index.end()) {
+            return std::nullopt;
+        }
+        return _vars[found->second].value;
+    }
+
+    std::span<const environment_variable> variables() const noexcept { return _vars; }
+    const char* const*                    envp() const noexcept { return _envp.data(); }
+};
+
+/**
+ * An atomic slot holding the process-wide snapshot, or null if it must be captured again. Uses
+ * std::atomic<std::shared_ptr> where the standard library provides it, and the atomic free
+ * functions for std::shared_ptr otherwise.
+ */
+class btr::environment_snapshot::slot {
+    using pointer = std::shared_ptr<const impl>;
+#if __cpp_lib_atomic_shared_ptr >= 201711L
+    std::atomic<pointer> _ptr;
+
+public:
+    pointer load() const noexcept { return _ptr.load(); }
+    void    store(pointer p) noexcept { _ptr.store(std::move(p)); }
+    bool    compare_exchange(pointer& expect, pointer p) noexcept {
+        return _ptr.compare_exchange_strong(expect, std::move(p));
     }
-    return btr::u8_as_char_encode(*val);
+#else
+    pointer _ptr;
+
+public:
+    pointer load() const noexcept { return std::atomic_load(&_ptr); }
+    void    store(pointer p) noexcept { std::atomic_store(&_ptr, std::move(p)); }
+    bool    compare_exchange(pointer& expect, pointer p) noexcept {
+        return std::atomic_compare_exchange_strong(&_ptr, &expect, std::move(p));
+    }
+#endif
+};
+
+namespace {
+
+/// Held shared while reading the environment of the process, and exclusively while modifying it
+std::shared_mutex& environment_mutex() noexcept {
+    static std::shared_mutex inst;
+    return inst;
 }
 
-std::optional<std::u8string> btr::u8getenv(u8view key) noexcept {
-    auto val = getenv_wstr(btr::wide_encode(key.u8string_view()));
-    if (!val) {
-        return std::nullopt;
+/// Copy the environment of the process, without racing a concurrent btr::setenv()
+std::string capture_environment_block() {
+    std::shared_lock lk{environment_mutex()};
+    return read_environment_block();
+}
+
+void check_env_name(u8view name) {
+    const auto sv = name.string_view();
+    neo_assert(expects,
+               !sv.empty() && sv.find('=') == sv.npos,
+               "Invalid environment variable name",
+               sv);
+}
+
+}  // namespace
+
+btr::environment_snapshot::environment_snapshot()
+    : _impl(std::make_shared<impl>(capture_environment_block())) {}
+
+environment_snapshot::slot& btr::environment_snapshot::_current_slot() noexcept {
+    static slot inst;
+    return inst;
+}
+
+environment_snapshot btr::environment_snapshot::current() {
+    auto& cur = _current_slot();
+    if (auto ptr = cur.load()) {
+        return environment_snapshot{std::move(ptr)};
     }
-    return btr::u8encode(*val);
+    // Nothing is published: Capture the environment now. Writers cannot run while we hold the lock,
+    // so no modification can be lost between reading the environment and publishing it.
+    std::shared_lock            lk{environment_mutex()};
+    std::shared_ptr<const impl> expect;
+    auto                        fresh = std::make_shared<const impl>(read_environment_block());
+    if (cur.compare_exchange(expect, fresh)) {
+        return environment_snapshot{std::move(fresh)};
+    }
+    // Another reader published first
+    return environment_snapshot{std::move(expect)};
 }
 
-#endif
+void btr::environment_snapshot::invalidate_current() { _current_slot().store({}); }
+
+std::optional<u8view> btr::environment_snapshot::get(u8view name) const noexcept {
+    return _impl->get(name.string_view());
+}
+
+std::span<const environment_variable> btr::environment_snapshot::variables() const noexcept {
+    return _impl->variables();
+}
+
+const char* const* btr::environment_snapshot::envp() const noexcept { return _impl->envp(); }
+
+void btr::setenv(u8view name, u8view value) {
+    check_env_name(name);
+    std::unique_lock lk{environment_mutex()};
+    set_process_env(name, &value);
+    // The next call to current() captures the modified environment
+    environment_snapshot::invalidate_current();
+}
+
+void btr::unsetenv(u8view name) {
+    check_env_name(name);
+    std::unique_lock lk{environment_mutex()};
+    set_process_env(name, nullptr);
+    environment_snapshot::invalidate_current();
+}
+
+std::shared_lock<std::shared_mutex> btr::environ_detail::lock_environment_for_read() {
+    return std::shared_lock{environment_mutex()};
+}
+
+std::optional<btr::u8string> btr::getenv(u8view key) noexcept {
+    std::shared_lock lk{environment_mutex()};
+    return get_process_env(key);
+}
+
+std::optional<btr::u8string> btr::u8getenv(u8view key) noexcept { return btr::getenv(key); }
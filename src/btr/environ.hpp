@@ -1,9 +1,13 @@
 #pragma once
 
+#include "./u8string.hpp"
 #include "./u8view.hpp"
 #include "./utf.hpp"
 
+#include <memory>
 #include <optional>
+#include <shared_mutex>
+#include <span>
 #include <string>
 
 namespace btr {
@@ -11,16 +15,141 @@ namespace btr {
 /**
  * @brief Get the environment variable named by the given key
  *
+ * The value is read from the live environment of the process, so changes made by any means (e.g.
+ * ::setenv() from other code) are seen immediately. Use environment_snapshot for repeated lookups
+ * that need not scan the environment.
+ *
  * @param key The name of an environment variable to get
  */
-std::optional<std::string> getenv(u8view key) noexcept;
+std::optional<btr::u8string> getenv(u8view key) noexcept;
 
 /**
  * @brief Get an environment variable value as a UTF-8 encoded string
  *
  * @param key The name of the variable to get
- * @return std::optional<std::u8string>
+ * @return std::optional<btr::u8string>
+ */
+std::optional<btr::u8string> u8getenv(u8view key) noexcept;
+
+/**
+ * @brief A single variable within an environment_snapshot
+ */
+struct environment_variable {
+    /// The name of the variable
+    u8view name;
+    /// The value of the variable
+    u8view value;
+};
+
+/**
+ * @brief An immutable copy of the environment of the process, indexed for fast lookup.
+ *
+ * The environment is read once when the snapshot is captured. Lookups are then hash lookups that
+ * return views into the snapshot, without scanning the environment or allocating. Copies of a
+ * snapshot share the same underlying data, and a snapshot may be used from multiple threads
+ * simultaneously.
+ *
+ * On Windows, variable names are compared case-insensitively.
+ */
+class environment_snapshot {
+    class impl;
+    std::shared_ptr<const impl> _impl;
+
+    /// Holds the process-wide snapshot
+    class slot;
+    static slot& _current_slot() noexcept;
+
+    explicit environment_snapshot(std::shared_ptr<const impl> p) noexcept
+        : _impl(std::move(p)) {}
+
+public:
+    /// Capture a new snapshot of the current environment of the process
+    environment_snapshot();
+
+    /**
+     * @brief Obtain the shared process-wide snapshot of the environment.
+     *
+     * The snapshot is captured upon first use, and is captured again upon the first use after
+     * btr::setenv(), btr::unsetenv(), or invalidate_current(). Capturing the snapshot waits for any
+     * concurrent btr::setenv() or btr::unsetenv() to finish; otherwise, obtaining the snapshot
+     * does not take a lock. Snapshots that were previously obtained are not modified.
+     */
+    [[nodiscard]] static environment_snapshot current();
+
+    /**
+     * @brief Mark the process-wide snapshot as out-of-date, so that the next call to current()
+     * reads the environment of the process again.
+     *
+     * This is only required after modifying the environment by other means than btr::setenv() and
+     * btr::unsetenv(), e.g. with ::setenv() directly.
+     */
+    static void invalidate_current();
+
+    /**
+     * @brief Get the value of the variable with the given name.
+     *
+     * @return std::optional<u8view> A view of the value. The view remains valid for as long as any
+     *      copy of the snapshot exists.
+     */
+    [[nodiscard]] std::optional<u8view> get(u8view name) const noexcept;
+
+    /// Determine whether the snapshot contains a variable with the given name
+    [[nodiscard]] bool contains(u8view name) const noexcept { return get(name).has_value(); }
+
+    /// Get the number of variables in the snapshot
+    [[nodiscard]] std::size_t size() const noexcept { return variables().size(); }
+
+    /// Get every variable in the snapshot, in the order they appeared in the environment
+    [[nodiscard]] std::span<const environment_variable> variables() const noexcept;
+
+    /**
+     * @brief Get a null-terminated array of null-terminated "name=value" strings, suitable as the
+     * `envp` of a new process.
+     */
+    [[nodiscard]] const char* const* envp() const noexcept;
+};
+
+/**
+ * @brief Set the value of an environment variable.
+ *
+ * The environment of the process is modified, and the process-wide environment_snapshot is marked
+ * out-of-date. Calls to setenv() and unsetenv() are serialized with each other and with
+ * btr::getenv(), so threads that concurrently use btr::getenv() see either the old or the new
+ * value. Snapshots that were already obtained are not modified.
+ *
+ * @param name The name of the variable. Must be non-empty and must not contain an equal sign.
+ * @param value The new value of the variable
  */
-std::optional<std::u8string> u8getenv(u8view key) noexcept;
+void setenv(u8view name, u8view value);
+
+/**
+ * @brief Remove a variable from the environment, if it is present.
+ *
+ * @see setenv()
+ */
+void unsetenv(u8view name);
+
+/**
+ * @brief Get the environment variable named by the given key from the given snapshot, without
+ * allocating.
+ *
+ * @param key The name of an environment variable to get
+ * @param env The snapshot to search. The returned view remains valid for as long as any copy of
+ *      the snapshot exists.
+ */
+[[nodiscard]] inline std::optional<u8view> getenv(u8view                      key,
+                                                  const environment_snapshot& env) noexcept {
+    return env.get(key);
+}
+
+namespace environ_detail {
+
+/**
+ * Lock out btr::setenv() and btr::unsetenv() while the caller reads the environment of the process
+ * by other means (e.g. by forking a child that inherits it).
+ */
+[[nodiscard]] std::shared_lock<std::shared_mutex> lock_environment_for_read();
+
+}  // namespace environ_detail
 
 }  // namespace btr
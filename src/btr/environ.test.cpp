@@ -2,10 +2,140 @@
 
 #include <catch2/catch.hpp>
 
+#include <atomic>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
 TEST_CASE("Get an environment variable") {
     auto path = btr::getenv("PATH");
     CHECK(path);
 
     auto u8path = btr::u8getenv("PATH");
     CHECK(*path == btr::u8view(*u8path).string_view());
+
+#if !_WIN32
+    // getenv() sees changes made by other means, without invalidating the snapshot
+    auto snap = btr::environment_snapshot::current();
+    ::setenv("BTR_TEST_LIVE_VARIABLE", "live", 1);
+    CHECK(btr::getenv("BTR_TEST_LIVE_VARIABLE") == btr::u8view("live"));
+    CHECK_FALSE(snap.contains("BTR_TEST_LIVE_VARIABLE"));
+    ::unsetenv("BTR_TEST_LIVE_VARIABLE");
+    CHECK_FALSE(btr::getenv("BTR_TEST_LIVE_VARIABLE"));
+#endif
+}
+
+TEST_CASE("Look up variables in a snapshot of the environment") {
+    auto env  = btr::environment_snapshot::current();
+    auto path = btr::getenv("PATH", env);
+    REQUIRE(path);
+    CHECK(path->string_view() == btr::getenv("PATH")->string_view());
+    CHECK_FALSE(env.get("BTR_SURELY_UNDEFINED_VARIABLE"));
+
+#if !_WIN32
+    // Views into a snapshot remain valid after the environment changes
+    auto old_value = env.get("PATH")->string_view();
+    ::setenv("PATH", "/nonexistent", 1);
+    btr::environment_snapshot::invalidate_current();
+    CHECK(env.get("PATH")->string_view() == old_value);
+    CHECK(btr::environment_snapshot::current().get("PATH")->string_view() == "/nonexistent");
+    CHECK(btr::environment_snapshot{}.get("PATH")->string_view() == "/nonexistent");
+    ::setenv("PATH", std::string(old_value).c_str(), 1);
+    btr::environment_snapshot::invalidate_current();
+#endif
+
+    std::size_t n_path = 0;
+    for (auto& var : env.variables()) {
+        n_path += var.name.string_view() == "PATH";
+    }
+    CHECK(n_path == 1);
+    CHECK(env.contains("PATH"));
+}
+
+TEST_CASE("Modify the environment") {
+    auto before = btr::environment_snapshot::current();
+    btr::setenv("BTR_TEST_VARIABLE", "first");
+    CHECK(btr::getenv("BTR_TEST_VARIABLE") == btr::u8view("first"));
+    CHECK(std::getenv("BTR_TEST_VARIABLE") == std::string_view("first"));
+    CHECK_FALSE(before.contains("BTR_TEST_VARIABLE"));
+
+    auto first = btr::environment_snapshot::current();
+    btr::setenv("BTR_TEST_VARIABLE", "second");
+    CHECK(first.get("BTR_TEST_VARIABLE")->string_view() == "first");
+    CHECK(btr::getenv("BTR_TEST_VARIABLE") == btr::u8view("second"));
+
+    // The envp array has every variable, including the modified one
+    std::size_t n_envp = 0;
+    bool        found  = false;
+    auto        env    = btr::environment_snapshot::current();
+    for (auto ptr = env.envp(); *ptr; ++ptr) {
+        ++n_envp;
+        found = found || *ptr == std::string_view("BTR_TEST_VARIABLE=second");
+    }
+    CHECK(found);
+    CHECK(n_envp == env.size());
+
+    btr::unsetenv("BTR_TEST_VARIABLE");
+    CHECK_FALSE(btr::getenv("BTR_TEST_VARIABLE"));
+    CHECK_FALSE(std::getenv("BTR_TEST_VARIABLE"));
+    CHECK(btr::environment_snapshot::current().size() == before.size());
+    // Removing an absent variable is not an error
+    btr::unsetenv("BTR_TEST_VARIABLE");
+}
+
+TEST_CASE("Read the environment while it is modified") {
+    std::atomic<bool>        done{false};
+    std::atomic<int>         n_bad{0};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&] {
+            while (!done.load()) {
+                auto val = btr::getenv("BTR_TEST_COUNTER");
+                if (val && val->empty()) {
+                    ++n_bad;
+                }
+            }
+        });
+    }
+    for (int n = 0; n < 500; ++n) {
+        btr::setenv("BTR_TEST_COUNTER", std::to_string(n));
+    }
+    done = true;
+    for (auto& t : readers) {
+        t.join();
+    }
+    CHECK(n_bad == 0);
+    CHECK(btr::getenv("BTR_TEST_COUNTER") == btr::u8view("499"));
+    btr::unsetenv("BTR_TEST_COUNTER");
+}
+
+TEST_CASE("Capture snapshots while the environment grows") {
+    std::atomic<bool>        done{false};
+    std::atomic<int>         n_bad{0};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&, i] {
+            while (!done.load()) {
+                // Adding variables may reallocate the environment while a snapshot copies it
+                auto env = i % 2 ? btr::environment_snapshot{}
+                                 : btr::environment_snapshot::current();
+                if (!env.contains("PATH")) {
+                    ++n_bad;
+                }
+            }
+        });
+    }
+    for (int n = 0; n < 200; ++n) {
+        btr::setenv("BTR_TEST_GROW_" + std::to_string(n), "value");
+    }
+    done = true;
+    for (auto& t : readers) {
+        t.join();
+    }
+    CHECK(n_bad == 0);
+    CHECK(btr::environment_snapshot{}.contains("BTR_TEST_GROW_199"));
+    for (int n = 0; n < 200; ++n) {
+        btr::unsetenv("BTR_TEST_GROW_" + std::to_string(n));
+    }
 }
@@ -1,8 +1,12 @@
 #include "./file.hpp"
 
+#include "./native_file.hpp"
+
 #include <neo/assert.hpp>
 #include <neo/ufmt.hpp>
 
+#include <random>
+
 using namespace btr;
 
 using std::filesystem::path;
@@ -53,6 +57,23 @@ std::size_t file::do_write(const_buffer buf) {
 }
 
 std::string file::read(std::filesystem::path const& filepath) {
-    auto f = open(filepath);
-    return f.read();
+    // Read directly into the string, without the intermediate buffering of <cstdio>
+    return native_file::open(filepath).read_all();
+}
+
+void file::flush() {
+    if (std::fflush(_file) != 0) {
+        throw file_error(std::error_code{errno, std::system_category()}, "Failed to flush file");
+    }
+}
+
+path file::_temp_path_for(const path& fpath) {
+    thread_local std::mt19937_64 rng{std::random_device{}()};
+    auto                         n    = rng();
+    auto                         name = fpath.filename().string() + ".tmp-";
+    for (auto i = 0; i < 16; ++i) {
+        name.push_back("0123456789abcdef"[n & 0xf]);
+        n >>= 4;
+    }
+    return fpath.parent_path() / name;
 }
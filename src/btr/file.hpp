@@ -31,6 +31,24 @@ struct file_not_found_error : file_error {
     using file_error::file_error;
 };
 
+/**
+ * @brief Options for file::write_atomic()
+ */
+struct atomic_write_options {
+    /**
+     * @brief If `true`, flush the new content to the storage device before it replaces the old
+     * file, so that a crash or power loss cannot leave an empty or partially written file in place.
+     */
+    bool sync_file = true;
+    /**
+     * @brief If `true`, also flush the directory that contains the file, so that the replacement
+     * itself survives a crash or power loss.
+     *
+     * @note On Windows, this requests a write-through rename instead
+     */
+    bool sync_directory = false;
+};
+
 /**
  * @brief A very simple file class, which can be used to read and write files.
  *
@@ -53,6 +71,13 @@ class file : public byte_io_stream {
     /// Write data into the file
     std::size_t do_write(const_buffer buf) override;
 
+    /// Generate a unique path for a temporary file in the same directory as the given file
+    static std::filesystem::path _temp_path_for(const std::filesystem::path& filepath);
+
+    /// Replace the file at the given path with the given content
+    static void
+    _write_atomic(const std::filesystem::path& filepath, const_buffer, atomic_write_options);
+
 public:
     using byte_io_stream::read;
     using byte_io_stream::write;
@@ -83,6 +108,30 @@ public:
         _file = nullptr;
     }
 
+    /**
+     * @brief Write any data buffered by the C library to the OS
+     *
+     * @throws file_error if the data cannot be written
+     */
+    void flush();
+
+    /**
+     * @brief Flush buffered data, then flush the data and metadata of the file to the storage
+     * device, so that they survive a crash or power loss.
+     *
+     * @throws file_error if the file cannot be flushed
+     */
+    void sync();
+
+    /**
+     * @brief As with sync(), but skip metadata that is not required to read the data back (e.g.
+     * the modification time). On platforms that do not distinguish the two, this is equivalent to
+     * sync().
+     *
+     * @throws file_error if the file cannot be flushed
+     */
+    void datasync();
+
     /**
      * @brief Open a file with the specified mode
      *
@@ -128,6 +177,31 @@ public:
         auto f = open(filepath, "wb");
         f.write(content);
     }
+
+    /**
+     * @brief Atomically replace the file at the designated path with the given data
+     *
+     * The data is written to a temporary file in the same directory, which is then renamed over
+     * the destination. Readers observe either the old content or the new content, never a
+     * partially written file, and the old content is left in place if writing fails.
+     *
+     * If writing fails, the temporary file is removed. If the process is killed or the system
+     * crashes before the rename, a temporary file named `<filename>.tmp-<random>` may remain.
+     *
+     * On POSIX systems, the replacement keeps the permission bits of the file that it replaces.
+     * On Windows, it has the default attributes and security of a new file in the directory.
+     *
+     * @param filepath The path to a file that will be written or replaced
+     * @param content The data to write into the file
+     * @param opts Options controlling durability
+     *
+     * @throws file_error if the file cannot be written
+     */
+    static void write_atomic(const std::filesystem::path& filepath,
+                             trivial_range auto&&         content,
+                             atomic_write_options         opts = {}) {
+        _write_atomic(filepath, const_buffer(content), opts);
+    }
 };
 
 }  // namespace btr
@@ -0,0 +1,145 @@
+#include "./file.hpp"
+
+#include "./native_io.hpp"
+
+#include <neo/ufmt.hpp>
+
+#if !_WIN32
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+
+using namespace btr;
+
+using std::filesystem::path;
+
+namespace {
+
+[[noreturn]] void throw_write_error(int err, const path& fpath, const char* what) {
+    throw file_error(std::error_code{err, std::system_category()},
+                     neo::ufmt("Failed to atomically write file [{}]: {}", fpath.string(), what));
+}
+
+/// Open an unnamed file in the given directory, or return a closed stream if that is not supported
+native_io_stream open_unnamed_file(const path& dir) {
+#ifdef O_TMPFILE
+    int fd = ::open(dir.c_str(), O_TMPFILE | O_WRONLY | O_CLOEXEC, 0666);
+    if (fd >= 0) {
+        return native_io_stream{NEO_MOVE(fd)};
+    }
+#endif
+    (void)dir;
+    return native_io_stream{};
+}
+
+void write_all(native_io_stream& io, const_buffer buf, const path& fpath) {
+    try {
+        while (buf.size()) {
+            buf = buf + posix_fd_traits::write(io.get(), buf);
+        }
+    } catch (const std::system_error& e) {
+        throw_write_error(e.code().value(), fpath, "Failed to write the new file content");
+    }
+}
+
+void sync_file(native_io_stream& io, bool sync, const path& fpath) {
+    if (!sync) {
+        return;
+    }
+    try {
+        io.datasync();
+    } catch (const std::system_error& e) {
+        throw_write_error(e.code().value(), fpath, "Failed to sync the new file content");
+    }
+}
+
+}  // namespace
+
+void file::sync() {
+    flush();
+    try {
+        posix_fd_traits::sync(::fileno(_file));
+    } catch (const std::system_error& e) {
+        throw file_error(e.code(), "Failed to sync file");
+    }
+}
+
+void file::datasync() {
+    flush();
+    try {
+        posix_fd_traits::datasync(::fileno(_file));
+    } catch (const std::system_error& e) {
+        throw file_error(e.code(), "Failed to sync file");
+    }
+}
+
+void file::_write_atomic(const path& fpath, const_buffer content, atomic_write_options opts) {
+    auto dir = fpath.parent_path();
+    if (dir.empty()) {
+        dir = ".";
+    }
+    const auto tmp = _temp_path_for(fpath);
+
+    // Keep the permissions of the file that we are replacing
+    struct ::stat existing;
+    const bool    replacing = ::stat(fpath.c_str(), &existing) == 0;
+
+    // An unnamed file is never left behind if we fail or crash while writing it. (Once it has been
+    // linked into place, a crash before the rename can still leave the temporary file.)
+    auto io = open_unnamed_file(dir);
+    if (io.is_open()) {
+        write_all(io, content, fpath);
+        sync_file(io, opts.sync_file, fpath);
+        if (replacing) {
+            ::fchmod(io.get(), existing.st_mode & 07777);
+        }
+        // An unnamed file cannot be linked over an existing file, so give it a temporary name
+        auto fd_path = "/proc/self/fd/" + std::to_string(io.get());
+        if (::linkat(AT_FDCWD, fd_path.c_str(), AT_FDCWD, tmp.c_str(), AT_SYMLINK_FOLLOW) != 0) {
+            // /proc may not be mounted. Fall back to a named temporary file.
+            io.close();
+        }
+    }
+    if (!io.is_open()) {
+        int fd = ::open(tmp.c_str(), O_CREAT | O_EXCL | O_WRONLY | O_CLOEXEC, 0666);
+        if (fd < 0) {
+            throw_write_error(errno, fpath, "Failed to create a temporary file");
+        }
+        io = native_io_stream{NEO_MOVE(fd)};
+        try {
+            write_all(io, content, fpath);
+            sync_file(io, opts.sync_file, fpath);
+        } catch (...) {
+            ::unlink(tmp.c_str());
+            throw;
+        }
+        if (replacing) {
+            ::fchmod(io.get(), existing.st_mode & 07777);
+        }
+    }
+    io.close();
+
+    if (::rename(tmp.c_str(), fpath.c_str()) != 0) {
+        const int err = errno;
+        ::unlink(tmp.c_str());
+        throw_write_error(err, fpath, "::rename() failed");
+    }
+
+    if (opts.sync_directory) {
+        int dir_fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dir_fd < 0) {
+            throw_write_error(errno, fpath, "Failed to open the parent directory to sync it");
+        }
+        native_io_stream dir_io{NEO_MOVE(dir_fd)};
+        try {
+            dir_io.sync();
+        } catch (const std::system_error& e) {
+            throw_write_error(e.code().value(), fpath, "Failed to sync the parent directory");
+        }
+    }
+}
+
+#endif
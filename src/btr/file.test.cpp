@@ -39,3 +39,49 @@ TEST_CASE("Write some non-byte-sized data") {
     f.close();
     std::filesystem::remove(THIS_DIR / "test.data");
 }
+
+TEST_CASE("Atomically replace a file") {
+    auto fpath = THIS_DIR / "test-atomic.txt";
+    btr::file::write(fpath, "Old content\n");
+    btr::file::write_atomic(fpath, "New content\n");
+    CHECK(btr::file::read(fpath) == "New content\n");
+
+    // Write a new file, with every durability option
+    std::filesystem::remove(fpath);
+    btr::file::write_atomic(fpath,
+                            "Durable content\n",
+                            {.sync_file = true, .sync_directory = true});
+    CHECK(btr::file::read(fpath) == "Durable content\n");
+
+    // No temporary files are left behind
+    for (auto& ent : std::filesystem::directory_iterator{THIS_DIR}) {
+        CHECK(ent.path().filename().string().find(".tmp-") == std::string::npos);
+    }
+    std::filesystem::remove(fpath);
+
+    // Failure to write leaves nothing behind
+    CHECK_THROWS_AS(btr::file::write_atomic(THIS_DIR / "non-existent-subdir/file.txt", "Nope"),
+                    btr::file_error);
+    // A directory cannot be replaced by a file, so this fails after the content has been written
+    auto dirpath = THIS_DIR / "test-atomic-dir";
+    std::filesystem::create_directories(dirpath);
+    btr::file::write(dirpath / "child.txt", "Child content\n");
+    CHECK_THROWS_AS(btr::file::write_atomic(dirpath, "Nope"), btr::file_error);
+    CHECK(std::filesystem::is_directory(dirpath));
+    for (auto& ent : std::filesystem::directory_iterator{THIS_DIR}) {
+        CHECK(ent.path().filename().string().find(".tmp-") == std::string::npos);
+    }
+    std::filesystem::remove_all(dirpath);
+}
+
+TEST_CASE("Sync a file") {
+    auto fpath = THIS_DIR / "test-sync.txt";
+    auto f     = btr::file::open(fpath, "wb");
+    f.write(std::string_view("Some data"));
+    f.sync();
+    f.write(std::string_view(" and more data"));
+    f.datasync();
+    f.close();
+    CHECK(btr::file::read(fpath) == "Some data and more data");
+    std::filesystem::remove(fpath);
+}
@@ -0,0 +1,76 @@
+#include "./file.hpp"
+
+#include "./native_io.hpp"
+
+#include <neo/ufmt.hpp>
+
+#if _WIN32
+
+#include <windows.h>
+
+#include <io.h>
+
+using namespace btr;
+
+using std::filesystem::path;
+
+namespace {
+
+[[noreturn]] void throw_write_error(DWORD err, const path& fpath, const char* what) {
+    throw file_error(std::error_code{static_cast<int>(err), std::system_category()},
+                     neo::ufmt("Failed to atomically write file [{}]: {}", fpath.string(), what));
+}
+
+}  // namespace
+
+void file::sync() {
+    flush();
+    try {
+        win32_handle_traits::sync(reinterpret_cast<HANDLE>(::_get_osfhandle(::_fileno(_file))));
+    } catch (const std::system_error& e) {
+        throw file_error(e.code(), "Failed to sync file");
+    }
+}
+
+void file::datasync() { sync(); }
+
+void file::_write_atomic(const path& fpath, const_buffer content, atomic_write_options opts) {
+    const auto tmp = _temp_path_for(fpath);
+    HANDLE     h   = ::CreateFileW(tmp.c_str(),
+                                   GENERIC_WRITE,
+                                   0,
+                                   nullptr,
+                                   CREATE_NEW,
+                                   FILE_ATTRIBUTE_NORMAL,
+                                   nullptr);
+    if (h == INVALID_HANDLE_VALUE) {
+        throw_write_error(::GetLastError(), fpath, "Failed to create a temporary file");
+    }
+    native_io_stream io{NEO_MOVE(h)};
+    try {
+        while (content.size()) {
+            content = content + win32_handle_traits::write(io.get(), content);
+        }
+        if (opts.sync_file) {
+            io.sync();
+        }
+    } catch (const std::system_error& e) {
+        io.close();
+        ::DeleteFileW(tmp.c_str());
+        throw_write_error(static_cast<DWORD>(e.code().value()),
+                          fpath,
+                          "Failed to write the new file content");
+    }
+    io.close();
+
+    // Windows cannot sync a directory, but can wait for the rename to reach the disk
+    const DWORD flags
+        = MOVEFILE_REPLACE_EXISTING | (opts.sync_directory ? MOVEFILE_WRITE_THROUGH : 0);
+    if (!::MoveFileExW(tmp.c_str(), fpath.c_str(), flags)) {
+        const auto err = ::GetLastError();
+        ::DeleteFileW(tmp.c_str());
+        throw_write_error(err, fpath, "::MoveFileExW() failed");
+    }
+}
+
+#endif
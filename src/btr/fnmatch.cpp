@@ -1,185 +1,898 @@
 #include "./fnmatch.hpp"
 
-#include <cassert>
-
+#include <neo/assert.hpp>
 #include <neo/ufmt.hpp>
 #include <neo/utf8.hpp>
+#include <neo/utility.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
 
-using char32ptr = const char32_t*;
-using std::string_view;
 using std::u32string_view;
 
 using namespace btr;
 
-using u8_cp_range = btr::codepoint_range<std::u8string_view>;
-using u8_iter     = u8_cp_range::iterator;
-
 namespace {
 
-enum match_result : int {
-    yes,
-    no,
-    never,
+/// The kind of a single element of a compiled fnmatch pattern
+enum class elem_kind : std::uint8_t {
+    /// A literal codepoint. Matches exactly that codepoint.
+    literal,
+    /// A '?'. Matches any single codepoint.
+    any_char,
+    /// A '[...]' group. Matches a single codepoint that is in the group.
+    oneof,
+    /// A '[!...]' group. Matches a single codepoint that is not in the group.
+    noneof,
+    /// A '*'. Matches any sequence of codepoints, including an empty sequence.
+    star,
+    /// The end of the pattern. Matches if there is no more input.
+    accept,
 };
 
-class base_pattern_elem {
-public:
-    virtual ~base_pattern_elem() = default;
+/**
+ * A pseudo-codepoint that represents a period at the start of the string (or at the start of a path
+ * element, with the 'pathname' option) when the 'leading_period' option is enabled. Only a literal
+ * period in the pattern will match it.
+ */
+constexpr char32_t leading_period = 0x110000;
 
-    // Attempt to match the given string
-    virtual match_result match(u8_iter first, u8_iter last) const noexcept = 0;
+/**
+ * A single position within a compiled pattern. A pattern is compiled to a sequence of these
+ * elements, which form the states of a nondeterministic finite automaton: Each element other than
+ * 'star' and 'accept' consumes a single codepoint and transitions to the next element. A 'star'
+ * element consumes any codepoint and remains in place, or may transition to the next element
+ * without consuming any input.
+ */
+struct pattern_elem {
+    elem_kind      kind;
+    char32_t       ch = 0;
+    std::u32string chars{};
+    /// For an 'accept' element, the index of the pattern that it ends
+    std::uint32_t pattern_index = 0;
+    /// If true, this element will not match a slash '/' (with the 'pathname' option)
+    bool no_slash = false;
 
-    std::unique_ptr<base_pattern_elem> next;
+    /// Check whether this element will consume the given codepoint
+    bool accepts_char(char32_t c) const noexcept {
+        if (c == leading_period) {
+            return kind == elem_kind::literal && ch == U'.';
+        }
+        if (c == U'/' && no_slash) {
+            return false;
+        }
+        switch (kind) {
+        case elem_kind::literal:
+            return c == ch;
+        case elem_kind::any_char:
+        case elem_kind::star:
+            return true;
+        case elem_kind::oneof:
+            return chars.find(c) != chars.npos;
+        case elem_kind::noneof:
+            return chars.find(c) == chars.npos;
+        case elem_kind::accept:
+            return false;
+        }
+        neo::unreachable();
+    }
 };
 
-class rt_star : public base_pattern_elem {
-    match_result match(u8_iter first, u8_iter last) const noexcept {
-        while (first != last) {
-            auto did_match = next->match(first, last);
-            if (did_match == yes) {
-                return yes;
-            } else if (did_match == never) {
-                return never;
+/**
+ * A set of NFA positions, stored as a bitset
+ */
+class position_set {
+    std::vector<std::uint64_t> _words;
+
+public:
+    explicit position_set(std::size_t n_positions)
+        : _words((n_positions + 63) / 64) {}
+
+    void insert(std::size_t pos) noexcept { _words[pos / 64] |= (std::uint64_t(1) << (pos % 64)); }
+    bool contains(std::size_t pos) const noexcept {
+        return (_words[pos / 64] >> (pos % 64)) & 1;
+    }
+    bool empty() const noexcept {
+        return std::ranges::all_of(_words, [](auto w) { return w == 0; });
+    }
+    void clear() noexcept { std::ranges::fill(_words, 0); }
+
+    /// Invoke `fn` with the index of each position in the set
+    void for_each(auto&& fn) const {
+        for (std::size_t idx = 0; idx < _words.size(); ++idx) {
+            auto word = _words[idx];
+            while (word) {
+                fn(idx * 64 + static_cast<std::size_t>(std::countr_zero(word)));
+                word &= word - 1;
             }
-            ++first;
         }
-        // We're at the end. Try once more
-        auto did_match = next->match(first, last);
-        if (did_match == no) {
-            // No matter how far the caller advances, we will never find a match
-            return never;
+    }
+
+    /**
+     * Compute the positions that follow those in `from` after consuming a single codepoint.
+     *
+     * `accepting` is the set of positions that will consume the codepoint, and `stars` is the set
+     * of positions that are stars. Each active and accepting star remains in place, and each other
+     * active and accepting position advances to the next position. Then each star that is reached
+     * also activates the position that follows it (there are never two consecutive stars).
+     *
+     * This operates on 64 positions at a time, and so requires O(m/64) operations for m positions.
+     */
+    static void advance(const position_set& from,
+                        const position_set& accepting,
+                        const position_set& stars,
+                        position_set&       out) noexcept {
+        std::uint64_t carry = 0;
+        for (std::size_t idx = 0; idx < out._words.size(); ++idx) {
+            const auto active = from._words[idx] & accepting._words[idx];
+            const auto moving = active & ~stars._words[idx];
+            out._words[idx]   = (active & stars._words[idx]) | (moving << 1) | carry;
+            carry             = moving >> 63;
+        }
+        carry = 0;
+        for (std::size_t idx = 0; idx < out._words.size(); ++idx) {
+            const auto reached = out._words[idx] & stars._words[idx];
+            out._words[idx] |= (reached << 1) | carry;
+            carry = reached >> 63;
         }
-        return did_match;
     }
-};
 
-/// This is for a "*" pattern that matches anything at all
-class rt_always : public base_pattern_elem {
-    match_result match(u8_iter, u8_iter) const noexcept override { return yes; }
+    bool operator==(const position_set&) const noexcept = default;
+
+    struct hash {
+        std::size_t operator()(const position_set& s) const noexcept {
+            std::size_t h = 0;
+            for (auto w : s._words) {
+                h = (h * 31) ^ std::hash<std::uint64_t>{}(w);
+            }
+            return h;
+        }
+    };
 };
 
-/// This is for a '*foo' pattern, where we only need to check that the string has the correct suffix
-class rt_endswith : public base_pattern_elem {
-    std::u32string suffix;
+/**
+ * A literal string that is compared against either the beginning or the end of an input string.
+ *
+ * Literals of up to eight bytes are compared using a single masked load of the first or last eight
+ * bytes of the input (when the input is that long), rather than a call to memcmp().
+ */
+class literal_probe {
+    std::string   _text;
+    bool          _at_end = false;
+    std::uint64_t _word   = 0;
+    std::uint64_t _mask   = 0;
+
+    static std::uint64_t _load(const void* ptr) noexcept {
+        std::uint64_t ret;
+        std::memcpy(&ret, ptr, sizeof ret);
+        return ret;
+    }
 
 public:
-    rt_endswith(u32string_view s)
-        : suffix(s) {}
+    literal_probe() = default;
+
+    literal_probe(std::string text, bool at_end)
+        : _text(std::move(text))
+        , _at_end(at_end) {
+        if (_text.size() > 8) {
+            return;
+        }
+        // Build the word and the mask in memory order, so that the comparison is independent of
+        // the endianness of the machine.
+        char word_bytes[8] = {};
+        char mask_bytes[8] = {};
+        auto offset        = _at_end ? 8 - _text.size() : 0;
+        std::memcpy(word_bytes + offset, _text.data(), _text.size());
+        std::memset(mask_bytes + offset, 0xff, _text.size());
+        _word = _load(word_bytes);
+        _mask = _load(mask_bytes);
+    }
+
+    /// Get the literal text
+    const std::string& text() const noexcept { return _text; }
 
-    match_result match(u8_iter first, u8_iter last) const noexcept override {
-        auto in_len = std::distance(first, last);
-        if (in_len < static_cast<std::ptrdiff_t>(suffix.size())) {
-            return never;
+    /// Check whether the given string begins with (or ends with) the literal
+    bool test(std::u8string_view str) const noexcept {
+        if (str.size() < _text.size()) {
+            return false;
         }
-        auto skip = in_len - suffix.size();
-        std::advance(first, skip);
-        auto eq = std::equal(first, last, suffix.begin());
-        return eq ? yes : never;
+        const auto start = _at_end ? str.data() + str.size() - _text.size() : str.data();
+        if (_text.size() <= 8 && str.size() >= 8) {
+            const auto load_at = _at_end ? str.data() + str.size() - 8 : str.data();
+            return (_load(load_at) & _mask) == _word;
+        }
+        return std::memcmp(start, _text.data(), _text.size()) == 0;
     }
 };
 
-class rt_any_char : public base_pattern_elem {
-    match_result match(u8_iter first, u8_iter last) const noexcept {
-        if (first == last) {
-            return no;
+/**
+ * A compiled pattern automaton.
+ *
+ * The pattern is stored as a sequence of NFA positions (see pattern_elem). Matching is performed by
+ * a DFA that is constructed lazily from the NFA as input is encountered, so each unit of input
+ * requires only a single table lookup once the relevant DFA states have been built.
+ *
+ * A single automaton may match several patterns at once: The positions of each pattern are stored
+ * one after another, each pattern ending with its own 'accept' element, and the DFA states record
+ * which of the patterns accept.
+ *
+ * The input alphabet is divided into classes: Each ASCII codepoint is its own class (and is indexed
+ * directly by its byte value), each non-ASCII codepoint that appears anywhere in the pattern is its
+ * own class, and every other codepoint belongs to a single shared class. Codepoints within the same
+ * class are indistinguishable to the pattern.
+ *
+ * The DFA may be built concurrently from multiple threads: Transitions are published atomically,
+ * and new states are constructed while holding a lock. If the number of DFA states exceeds a limit,
+ * matching falls back to simulating the NFA directly, which remains O(n*m).
+ */
+class automaton {
+public:
+    struct dfa_state {
+        position_set positions;
+        /// The indices of the patterns that accept in this state, in ascending order
+        std::vector<std::size_t> matches;
+        /// Whether no further input can cause any pattern to accept
+        bool dead = false;
+        /// Transitions for each character class. Null if not yet computed.
+        std::unique_ptr<std::atomic<const dfa_state*>[]> next;
+
+        bool accepting() const noexcept { return !matches.empty(); }
+    };
+
+private:
+    std::vector<pattern_elem> _elems;
+    /// Sorted list of non-ASCII codepoints that appear in the pattern
+    std::vector<char32_t> _named_chars;
+    /// The number of input character classes
+    std::size_t _n_classes = 0;
+    /// The class of a period at the start of the string, if leading periods are special
+    std::size_t _leading_period_class = 0;
+    /// The class of each ASCII codepoint, after case folding (if enabled)
+    std::uint8_t _ascii_class[128] = {};
+    /// For each input class, the set of positions that consume a codepoint of that class
+    std::vector<position_set> _class_masks;
+    /// The set of positions that are stars
+    position_set _stars{0};
+
+    fnmatch_options _opts;
+
+    static constexpr std::size_t max_dfa_states = 1024;
+    static constexpr std::size_t other_class    = 128;
+
+    using state_index = std::unordered_map<position_set, dfa_state*, position_set::hash>;
+
+    mutable std::mutex                              _mtx;
+    mutable std::vector<std::unique_ptr<dfa_state>> _states;
+    mutable state_index                             _state_index;
+    /// Set once the DFA has reached max_dfa_states, after which no more transitions are computed
+    mutable std::atomic<bool> _saturated{false};
+
+    const dfa_state* _start = nullptr;
+    const dfa_state* _dead  = nullptr;
+
+    /// Add the given position to the set, along with each position reachable without input
+    void _add_closure(position_set& set, std::size_t pos) const noexcept {
+        while (true) {
+            set.insert(pos);
+            if (_elems[pos].kind != elem_kind::star) {
+                break;
+            }
+            ++pos;
         }
-        return next->match(std::next(first), last);
     }
-};  // namespace
 
-class rt_oneof : public base_pattern_elem {
-    bool           _negative;
-    std::u32string _chars;
+    /// Compute the set of NFA positions reachable from 'from' after consuming a codepoint of the
+    /// given class
+    position_set _step(const position_set& from, std::size_t cls) const {
+        position_set ret{_elems.size()};
+        position_set::advance(from, _class_masks[cls], _stars, ret);
+        return ret;
+    }
 
-    match_result match(u8_iter first, u8_iter last) const noexcept {
-        if (first == last) {
-            return never;
+    /// Obtain a codepoint that is a member of the given input class
+    char32_t _class_representative(std::size_t cls) const noexcept {
+        if (cls < 128) {
+            return static_cast<char32_t>(cls);
         }
-        auto       idx         = _chars.find(*first);
-        const bool is_in_group = idx != _chars.npos;
-        if (is_in_group == _negative) {
-            // Either: We do not want any of the chars but we found one, OR
-            //         we wanted one of the chars but did not find it
-            return no;
-        } else {
-            return next->match(std::next(first), last);
+        if (cls == _leading_period_class) {
+            return leading_period;
+        }
+        if (cls > other_class) {
+            return _named_chars[cls - other_class - 1];
+        }
+        // The first non-ASCII codepoint that does not appear in the pattern
+        char32_t ret = 0x80;
+        for (auto c : _named_chars) {
+            if (c != ret) {
+                break;
+            }
+            ++ret;
         }
+        return ret;
     }
 
-public:
-    explicit rt_oneof(std::u32string&& chars, bool negative)
-        : _negative(negative)
-        , _chars(std::move(chars)) {}
+    /// Build the set of positions that consume each input class
+    void _build_masks() {
+        _stars = position_set{_elems.size()};
+        for (std::size_t pos = 0; pos < _elems.size(); ++pos) {
+            if (_elems[pos].kind == elem_kind::star) {
+                _stars.insert(pos);
+            }
+        }
+        _class_masks.reserve(_n_classes);
+        for (std::size_t cls = 0; cls < _n_classes; ++cls) {
+            const auto c    = _class_representative(cls);
+            auto&      mask = _class_masks.emplace_back(_elems.size());
+            for (std::size_t pos = 0; pos < _elems.size(); ++pos) {
+                if (!_elems[pos].accepts_char(c)) {
+                    continue;
+                }
+                if (c == leading_period && pos != 0 && _elems[pos - 1].kind == elem_kind::star) {
+                    // A leading period must be matched by a period at the start of the pattern (or
+                    // path element). A position that follows a star is only active by letting the
+                    // star match an empty string, which does not count.
+                    continue;
+                }
+                mask.insert(pos);
+            }
+        }
+    }
+
+    /// Append the index of each pattern that accepts in the given set of positions
+    void _collect_matches(const position_set& set, std::vector<std::size_t>& out) const {
+        set.for_each([&](std::size_t pos) {
+            if (_elems[pos].kind == elem_kind::accept) {
+                out.push_back(_elems[pos].pattern_index);
+            }
+        });
+    }
 
-};  // namespace
+    /// Obtain the DFA state for the given set of positions. Must be called with the lock held.
+    const dfa_state* _get_state(position_set&& set) const {
+        auto found = _state_index.find(set);
+        if (found != _state_index.end()) {
+            return found->second;
+        }
+        if (_states.size() >= max_dfa_states) {
+            return nullptr;
+        }
+        std::vector<std::size_t> matches;
+        _collect_matches(set, matches);
+        const bool dead = set.empty();
 
-class rt_lit : public base_pattern_elem {
-    std::u32string _lit;
+        auto st = std::unique_ptr<dfa_state>(new dfa_state{
+            std::move(set),
+            std::move(matches),
+            dead,
+            std::make_unique<std::atomic<const dfa_state*>[]>(_n_classes),
+        });
+        for (std::size_t i = 0; i < _n_classes; ++i) {
+            st->next[i].store(nullptr, std::memory_order_relaxed);
+        }
+        auto ptr = st.get();
+        _states.push_back(std::move(st));
+        _state_index.emplace(ptr->positions, ptr);
+        if (_states.size() >= max_dfa_states) {
+            _saturated.store(true, std::memory_order_release);
+        }
+        return ptr;
+    }
 
-    match_result match(u8_iter first, u8_iter last) const noexcept {
-        auto        probe     = first;
-        std::size_t remaining = 0;
-        while (probe != last and remaining < _lit.size()) {
-            ++probe;
-            ++remaining;
+    /**
+     * Compute (and cache) the transition from 'st' for the given class. Returns null if the DFA
+     * is full. Transitions that were not computed before then are never computed, so a full DFA
+     * does not take the lock again.
+     */
+    const dfa_state* _transition(const dfa_state& st, std::size_t cls) const {
+        if (_saturated.load(std::memory_order_acquire)) {
+            return nullptr;
         }
-        if (remaining < _lit.size()) {
-            return never;
+        std::unique_lock lk{_mtx};
+        auto             already = st.next[cls].load(std::memory_order_acquire);
+        if (already) {
+            return already;
         }
-        auto eq = std::equal(first, probe, _lit.begin());
-        if (!eq) {
-            return no;
+        auto next = _get_state(_step(st.positions, cls));
+        if (next) {
+            st.next[cls].store(next, std::memory_order_release);
         }
-        return next->match(probe, last);
+        return next;
+    }
+
+    std::size_t _class_of(char32_t c) const noexcept {
+        if (c < 128) {
+            return c;
+        }
+        if (c == leading_period) {
+            return _leading_period_class;
+        }
+        if (_named_chars.empty()) {
+            // An ASCII-only pattern: All non-ASCII codepoints are equivalent
+            return other_class;
+        }
+        auto found = std::ranges::lower_bound(_named_chars, c);
+        if (found != _named_chars.end() && *found == c) {
+            return other_class + 1 + static_cast<std::size_t>(found - _named_chars.begin());
+        }
+        return other_class;
+    }
+
+    /// Map a decoded input codepoint to the codepoint that is given to the pattern elements
+    char32_t _map_input(char32_t c) const noexcept {
+        return _opts.case_insensitive ? btr::simple_case_fold(c) : c;
+    }
+
+    /// Consume the remainder of the input by direct simulation of the NFA, without caching
+    position_set _simulate(const position_set& from,
+                           const char8_t*      ptr,
+                           const char8_t*      stop,
+                           bool                at_segment_start) const noexcept {
+        // Alternate between two buffers, rather than allocating a new set for each codepoint
+        position_set set = from;
+        position_set next{_elems.size()};
+        while (ptr != stop && !set.empty()) {
+            auto cp = neo::next_utf8_codepoint(ptr, stop);
+            if (cp.error() != neo::utf8_errc::none) {
+                set.clear();
+                break;
+            }
+            ptr += cp.size;
+            auto c = _map_input(cp.codepoint);
+            if (_opts.leading_period && c == U'.' && at_segment_start) {
+                c = leading_period;
+            }
+            at_segment_start = _opts.pathname && c == U'/';
+            position_set::advance(set, _class_masks[_class_of(c)], _stars, next);
+            std::swap(set, next);
+        }
+        return set;
+    }
+
+    /**
+     * Consume the given ASCII-only string, beginning in the given state. If `Contextual` is true,
+     * then periods at the start of a segment are given the leading_period class.
+     */
+    template <bool Contextual>
+    const dfa_state* _run_ascii(const dfa_state*              st,
+                                std::u8string_view            str,
+                                bool                          at_segment_start,
+                                std::optional<position_set>& fallback) const noexcept {
+        for (auto ptr = str.data(), stop = ptr + str.size(); ptr != stop; ++ptr) {
+            std::size_t cls = _ascii_class[*ptr];
+            if constexpr (Contextual) {
+                if (at_segment_start && *ptr == u8'.') {
+                    cls = _leading_period_class;
+                }
+            }
+            auto next = st->next[cls].load(std::memory_order_acquire);
+            if (!next) {
+                next = _transition(*st, cls);
+                if (!next) {
+                    // Too many DFA states. Simulate the NFA for the remainder of the input.
+                    fallback = _simulate(st->positions, ptr, stop, at_segment_start);
+                    return nullptr;
+                }
+            }
+            if (next->dead) {
+                // No further input can cause a match
+                return next;
+            }
+            st = next;
+            if constexpr (Contextual) {
+                at_segment_start = _opts.pathname && *ptr == u8'/';
+            }
+        }
+        return st;
+    }
+
+    /**
+     * Consume the given UTF-8 string, beginning in the given state. See _run_ascii(). If
+     * `known_valid`, the string is decoded without checking for errors.
+     */
+    template <bool Contextual>
+    const dfa_state* _run_utf8(const dfa_state*              st,
+                               std::u8string_view            str,
+                               bool                          at_segment_start,
+                               bool                          known_valid,
+                               std::optional<position_set>& fallback) const noexcept {
+        auto       ptr  = str.data();
+        const auto stop = ptr + str.size();
+        while (ptr != stop) {
+            const auto  prev = ptr;
+            char32_t    c;
+            std::size_t cls;
+            if (*ptr < 0x80) {
+                cls = _ascii_class[*ptr++];
+                c   = static_cast<char32_t>(cls);
+            } else if (known_valid) {
+                auto cp = utf_detail::ll_decode_valid(ptr);
+                ptr += cp.n_cus_taken;
+                c   = _map_input(cp.codepoint);
+                cls = _class_of(c);
+            } else {
+                auto cp = neo::next_utf8_codepoint(ptr, stop);
+                if (cp.error() != neo::utf8_errc::none) {
+                    // Invalid UTF-8 never matches
+                    return _dead;
+                }
+                ptr += cp.size;
+                c   = _map_input(cp.codepoint);
+                cls = _class_of(c);
+            }
+            if constexpr (Contextual) {
+                if (at_segment_start && c == U'.') {
+                    cls = _leading_period_class;
+                }
+            }
+            auto next = st->next[cls].load(std::memory_order_acquire);
+            if (!next) {
+                next = _transition(*st, cls);
+                if (!next) {
+                    // Too many DFA states. Simulate the NFA for the remainder of the input.
+                    fallback = _simulate(st->positions, prev, stop, at_segment_start);
+                    return nullptr;
+                }
+            }
+            if (next->dead) {
+                // No further input can cause a match
+                return next;
+            }
+            st = next;
+            if constexpr (Contextual) {
+                at_segment_start = _opts.pathname && c == U'/';
+            }
+        }
+        return st;
+    }
+
+    /**
+     * Consume the given string, beginning in the given state, and return the final state. If the
+     * limit on DFA states is reached, returns null and 'fallback' receives the final set of NFA
+     * positions instead.
+     *
+     * @param at_segment_start Whether the beginning of `str` is the start of the string (or of a
+     *      path element), for the purpose of matching leading periods
+     * @param known_valid Whether `str` is known to be valid UTF-8
+     */
+    const dfa_state* _run(const dfa_state*              st,
+                          std::u8string_view            str,
+                          bool                          at_segment_start,
+                          bool                          known_valid,
+                          std::optional<position_set>& fallback) const noexcept {
+        if (btr::is_ascii(str)) {
+            // Fast path: No decoding required.
+            return _opts.leading_period ? _run_ascii<true>(st, str, at_segment_start, fallback)
+                                        : _run_ascii<false>(st, str, at_segment_start, fallback);
+        }
+        return _opts.leading_period
+            ? _run_utf8<true>(st, str, at_segment_start, known_valid, fallback)
+            : _run_utf8<false>(st, str, at_segment_start, known_valid, fallback);
     }
 
 public:
-    explicit rt_lit(std::u32string&& lit)
-        : _lit(std::move(lit)) {}
-};
+    /**
+     * Create an automaton from the elements of one or more patterns, stored one after another. Each
+     * pattern must end with an 'accept' element.
+     */
+    explicit automaton(std::vector<pattern_elem> elems, const fnmatch_options& opts)
+        : _elems(std::move(elems))
+        , _opts(opts) {
+        for (auto& el : _elems) {
+            if (el.kind == elem_kind::literal && el.ch >= 128) {
+                _named_chars.push_back(el.ch);
+            }
+            for (char32_t c : el.chars) {
+                if (c >= 128) {
+                    _named_chars.push_back(c);
+                }
+            }
+        }
+        std::ranges::sort(_named_chars);
+        auto dup = std::ranges::unique(_named_chars);
+        _named_chars.erase(dup.begin(), dup.end());
+        _n_classes            = other_class + 1 + _named_chars.size() + 1;
+        _leading_period_class = _n_classes - 1;
+        for (std::size_t c = 0; c < 128; ++c) {
+            _ascii_class[c] = static_cast<std::uint8_t>(_map_input(static_cast<char32_t>(c)));
+        }
+        _build_masks();
+
+        // Every pattern begins at the start of the elements, or immediately after the end of the
+        // preceding pattern
+        position_set init{_elems.size()};
+        for (std::size_t pos = 0; pos < _elems.size(); ++pos) {
+            if (pos == 0 || _elems[pos - 1].kind == elem_kind::accept) {
+                _add_closure(init, pos);
+            }
+        }
+        std::unique_lock lk{_mtx};
+        _start = _get_state(std::move(init));
+        _dead  = _get_state(position_set{_elems.size()});
+    }
 
-class rt_end : public base_pattern_elem {
-    match_result match(u8_iter first, u8_iter last) const noexcept {
-        return first == last ? yes : no;
+    /// The initial state of the DFA
+    const dfa_state* start() const noexcept { return _start; }
+
+    /// Obtain the state after consuming the given codepoint, or null if there are too many states
+    const dfa_state* step(const dfa_state& st, char32_t c) const {
+        const auto cls  = _class_of(c);
+        auto       next = st.next[cls].load(std::memory_order_acquire);
+        return next ? next : _transition(st, cls);
+    }
+
+    /// Check whether consuming the given string from the given state leads to an accepting state
+    bool accepts(const dfa_state*   st,
+                 std::u8string_view str,
+                 bool               at_segment_start,
+                 bool               known_valid = false) const noexcept {
+        std::optional<position_set> fallback;
+        auto                        final_state = _run(st,
+                                                       str,
+                                                       at_segment_start,
+                                                       known_valid,
+                                                       fallback);
+        if (final_state) {
+            return final_state->accepting();
+        }
+        bool ret = false;
+        fallback->for_each(
+            [&](std::size_t pos) { ret = ret || _elems[pos].kind == elem_kind::accept; });
+        return ret;
+    }
+
+    /**
+     * Consume the given string from the start state, and obtain the indices of the patterns that
+     * accept it, in ascending order
+     */
+    void matches(std::u8string_view str, std::vector<std::size_t>& out) const {
+        out.clear();
+        std::optional<position_set> fallback;
+        auto                        final_state = _run(_start, str, true, false, fallback);
+        if (final_state) {
+            out = final_state->matches;
+        } else {
+            _collect_matches(*fallback, out);
+        }
+    }
+
+    /// Consume the given string from the start state, and obtain the lowest index of a pattern
+    /// that accepts it
+    std::optional<std::size_t> first_match(std::u8string_view str) const noexcept {
+        std::optional<position_set> fallback;
+        auto                        final_state = _run(_start, str, true, false, fallback);
+        if (final_state) {
+            if (final_state->matches.empty()) {
+                return std::nullopt;
+            }
+            return final_state->matches.front();
+        }
+        std::optional<std::size_t> ret;
+        fallback->for_each([&](std::size_t pos) {
+            if (!ret && _elems[pos].kind == elem_kind::accept) {
+                ret = _elems[pos].pattern_index;
+            }
+        });
+        return ret;
     }
 };
 
-}  // namespace
+/// Append the UTF-8 encoding of the given codepoint to the string
+void append_utf8(std::string& out, char32_t c) {
+    auto enc = utf_detail::ll_encode(c, tag_v<char8_t>);
+    out.append(reinterpret_cast<const char*>(enc.units), enc.count);
+}
 
-class btr::fnmatch_pattern::impl {
-    std::unique_ptr<base_pattern_elem>  _head;
-    std::unique_ptr<base_pattern_elem>* _next_to_compile = &_head;
+/// The shape of a pattern, and its literal prefix and suffix
+struct shape_info {
+    fnmatch_shape shape = fnmatch_shape::general;
+    /// The UTF-8 encoded run of literals that begins the pattern
+    std::string prefix;
+    /// The UTF-8 encoded run of literals that ends the pattern
+    std::string suffix;
+};
 
-    std::string    _spelling;
-    std::u32string _unicode = btr::transcode_string<char32_t>(_spelling);
+/// Classify the given sequence of pattern elements, which must end with an 'accept'
+shape_info classify(const std::vector<pattern_elem>& elems) {
+    shape_info ret;
+    auto       it   = elems.begin();
+    const auto stop = std::prev(elems.end());
+    for (; it != stop && it->kind == elem_kind::literal; ++it) {
+        append_utf8(ret.prefix, it->ch);
+    }
+    if (it == stop) {
+        // Every element is a literal
+        ret.shape  = fnmatch_shape::exact;
+        ret.suffix = ret.prefix;
+        return ret;
+    }
+    // Every element before the final 'accept' consumes exactly one codepoint, so a run of literals
+    // at the end of the pattern must match the end of the string.
+    auto rit = std::next(elems.rbegin());
+    for (; rit->kind == elem_kind::literal; ++rit) {
+        auto enc = utf_detail::ll_encode(rit->ch, tag_v<char8_t>);
+        ret.suffix.insert(0, reinterpret_cast<const char*>(enc.units), enc.count);
+    }
+    if (it->kind != elem_kind::star || std::next(it) != rit.base()) {
+        // Something other than a single star lies between the prefix and the suffix
+        return ret;
+    }
+    if (ret.prefix.empty() && ret.suffix.empty()) {
+        ret.shape = fnmatch_shape::always;
+    } else if (ret.suffix.empty()) {
+        ret.shape = fnmatch_shape::prefix;
+    } else if (!ret.prefix.empty()) {
+        ret.shape = fnmatch_shape::prefix_suffix;
+    } else if (ret.suffix.starts_with('.') && ret.suffix.find('.', 1) == ret.suffix.npos) {
+        ret.shape = fnmatch_shape::extension;
+    } else {
+        ret.shape = fnmatch_shape::suffix;
+    }
+    return ret;
+}
 
-    template <typename T, typename... Args>
-    void _add_elem(Args&&... args) {
-        *_next_to_compile = std::make_unique<T>(std::forward<Args>(args)...);
-        _next_to_compile  = &(*_next_to_compile)->next;
+/**
+ * A matcher for a single pattern. Before running the automaton, the string is checked for the
+ * minimum length, the literal prefix, and the literal suffix of the pattern. Patterns that consist
+ * of only literals and at most one star (see fnmatch_shape) are then fully matched by those checks,
+ * and other patterns run the automaton on the remainder of the string from the state that follows
+ * the prefix.
+ */
+class pattern_matcher {
+    automaton  _automaton;
+    shape_info _shape;
+    /// The shape that selects the matching strategy. Patterns with options always use the automaton
+    fnmatch_shape _strategy = fnmatch_shape::general;
+    /// Probes for the literal prefix and suffix of the pattern
+    literal_probe _prefix;
+    literal_probe _suffix;
+    /// The DFA state after consuming the prefix, and the number of bytes of the prefix consumed
+    const automaton::dfa_state* _after_prefix    = nullptr;
+    std::size_t                 _prefix_consumed = 0;
+    /// Whether the string following the consumed prefix begins a new path element
+    bool _resume_at_segment_start = true;
+    /// The minimum length (in bytes) of any matching string
+    std::size_t _min_length = 0;
+
+public:
+    pattern_matcher(std::vector<pattern_elem> elems_, const fnmatch_options& opts)
+        : _automaton(elems_, opts)
+        , _shape(classify(elems_)) {
+        const auto& elems = elems_;
+
+        _after_prefix = _automaton.start();
+        if (opts.case_insensitive) {
+            // Strings cannot be compared byte-by-byte, and case folding may change the length of
+            // the UTF-8 encoding. Only check that there is at least one byte for each element.
+            _min_length = static_cast<std::size_t>(std::ranges::count_if(elems, [](auto& el) {
+                return el.kind != elem_kind::star && el.kind != elem_kind::accept;
+            }));
+            return;
+        }
+        if (!opts.leading_period && !opts.pathname) {
+            _strategy = _shape.shape;
+        }
+
+        _prefix = literal_probe{_shape.prefix, false};
+        _suffix = literal_probe{_shape.suffix, true};
+
+        for (auto& el : elems) {
+            if (el.kind != elem_kind::literal) {
+                break;
+            }
+            auto next = _automaton.step(*_after_prefix, el.ch);
+            if (!next) {
+                break;
+            }
+            _prefix_consumed += utf_detail::ll_encode(el.ch, tag_v<char8_t>).count;
+            _after_prefix = next;
+        }
+        _resume_at_segment_start = _prefix_consumed == 0
+            || (opts.pathname && _shape.prefix[_prefix_consumed - 1] == '/');
+
+        for (auto& el : elems) {
+            if (el.kind == elem_kind::literal) {
+                _min_length += utf_detail::ll_encode(el.ch, tag_v<char8_t>).count;
+            } else if (el.kind != elem_kind::star && el.kind != elem_kind::accept) {
+                _min_length += 1;
+            }
+        }
     }
 
-    u32string_view _compile_oneof(u32string_view tail) {
+    const shape_info& shape() const noexcept { return _shape; }
+
+    /**
+     * Perform the inexpensive checks of the string's length, literal prefix, and literal suffix.
+     * If this returns false, the string does not match.
+     */
+    bool prefilter(std::u8string_view str) const noexcept {
+        return str.size() >= _min_length && _prefix.test(str) && _suffix.test(str);
+    }
+
+    /**
+     * Complete the match of a string that has passed the prefilter(). If `known_valid`, the string
+     * is known to be valid UTF-8.
+     */
+    bool match_prefiltered(std::u8string_view str, bool known_valid = false) const noexcept {
+        switch (_strategy) {
+        case fnmatch_shape::exact:
+            return str.size() == _min_length;
+        case fnmatch_shape::prefix:
+        case fnmatch_shape::suffix:
+        case fnmatch_shape::extension:
+        case fnmatch_shape::prefix_suffix:
+        case fnmatch_shape::always:
+            // The prefix and suffix do not overlap (the prefilter checked the length), so the
+            // remainder is matched by the star, which accepts any valid UTF-8.
+            return known_valid
+                || validate_utf8(str.substr(_shape.prefix.size(), str.size() - _min_length));
+        case fnmatch_shape::general:
+            str.remove_prefix(_prefix_consumed);
+            return _automaton.accepts(_after_prefix, str, _resume_at_segment_start, known_valid);
+        }
+        neo::unreachable();
+    }
+
+    bool match(std::u8string_view str, bool known_valid = false) const noexcept {
+        return prefilter(str) && match_prefiltered(str, known_valid);
+    }
+
+    std::size_t match_many(std::span<const u8view> strings,
+                           std::span<bool>         results) const noexcept {
+        // Run the prefilter over all strings first, so that it remains a tight loop that does not
+        // interleave with the automaton.
+        for (std::size_t idx = 0; idx < strings.size(); ++idx) {
+            results[idx] = prefilter(strings[idx].u8string_view());
+        }
+        std::size_t n_matched = 0;
+        for (std::size_t idx = 0; idx < strings.size(); ++idx) {
+            if (results[idx]) {
+                results[idx] = match_prefiltered(strings[idx].u8string_view());
+                n_matched += results[idx] ? 1 : 0;
+            }
+        }
+        return n_matched;
+    }
+};
+
+/**
+ * Parses an fnmatch pattern string into a sequence of pattern elements
+ */
+class pattern_parser {
+    const btr::u8string&      _spelling;
+    const fnmatch_options&    _opts;
+    std::vector<pattern_elem> _elems;
+
+    u32string_view _parse_oneof(u32string_view tail) {
         std::u32string chars;
         bool           negate = false;
-        if (tail.front() == '!') {
+        if (tail.starts_with(U"!")) {
             if (tail.starts_with(U"!]")) {
                 // Special '[!]' matches a single exclamation point
-                _add_elem<rt_oneof>(U"!", false);
+                _elems.push_back({elem_kind::oneof, 0, U"!"});
                 return tail.substr(2);
             }
             negate = true;
             tail.remove_prefix(1);
         }
+        const auto kind = negate ? elem_kind::noneof : elem_kind::oneof;
         if (tail.starts_with(U"]]")) {
-            _add_elem<rt_oneof>(U"]", negate);
+            _elems.push_back({kind, 0, U"]"});
             return tail.substr(2);
         }
         while (!tail.empty()) {
             auto c = tail.front();
             if (c == ']') {
                 // We've reached the end of the group
-                _add_elem<rt_oneof>(std::move(chars), negate);
+                _elems.push_back({kind, 0, std::move(chars)});
                 return tail.substr(1);
             } else {
                 chars.push_back(c);
@@ -189,85 +902,109 @@ class btr::fnmatch_pattern::impl {
         throw bad_fnmatch_pattern(_spelling, "Unterminated [group] in pattern");
     }
 
-    u32string_view _compile_lit(u32string_view tail) {
-        std::u32string lit;
+public:
+    pattern_parser(const btr::u8string& spelling, const fnmatch_options& opts)
+        : _spelling(spelling)
+        , _opts(opts) {}
+
+    std::vector<pattern_elem> parse() && {
+        const auto     unicode = btr::transcode_string<char32_t>(_spelling);
+        u32string_view tail    = unicode;
+        if (tail.starts_with(U"!")) {
+            throw bad_fnmatch_pattern(_spelling,
+                                      "Patterns starting with a literal exclamation point '!' "
+                                      "are reserved. Escape with square brackets [!]");
+        }
         while (!tail.empty()) {
             auto c = tail.front();
-            if (c == '*' || c == '[' || c == '?') {
-                break;
+            if (c == '*') {
+                // Consecutive stars are equivalent to a single star
+                if (_elems.empty() || _elems.back().kind != elem_kind::star) {
+                    _elems.push_back({elem_kind::star});
+                }
+                tail.remove_prefix(1);
+            } else if (c == '[') {
+                tail = _parse_oneof(tail.substr(1));
+            } else if (c == '?') {
+                _elems.push_back({elem_kind::any_char});
+                tail.remove_prefix(1);
             } else {
-                lit.push_back(c);
+                _elems.push_back({elem_kind::literal, c});
+                tail.remove_prefix(1);
             }
-            tail.remove_prefix(1);
-        }
-        _add_elem<rt_lit>(std::move(lit));
-        return tail;
-    }
-
-    void _compile_next(u32string_view tail) {
-        if (tail.empty()) {
-            return;
         }
-        auto c = tail.front();
-        if (c == '*') {
-            if (tail.size() == 1) {
-                _add_elem<rt_always>();
-                return;
-            } else if (tail.substr(1).find_first_of(U"*?[") == tail.npos) {
-                _add_elem<rt_endswith>(tail.substr(1));
-                return;
-            } else {
-                _add_elem<rt_star>();
-                _compile_next(tail.substr(1));
-            }
-        } else if (c == '[') {
-            tail = _compile_oneof(tail.substr(1));
-            _compile_next(tail);
-        } else if (c == '?') {
-            _add_elem<rt_any_char>();
-            _compile_next(tail.substr(1));
-        } else {
-            // Literal string
-            tail = _compile_lit(tail);
-            _compile_next(tail);
+        // Terminate the pattern with an 'accept' to detect the end-of-string
+        _elems.push_back({elem_kind::accept});
+        for (auto& el : _elems) {
+            if (_opts.case_insensitive) {
+                // Inputs are case-folded before they are given to the pattern elements
+                el.ch = btr::simple_case_fold(el.ch);
+                for (auto& c : el.chars) {
+                    c = btr::simple_case_fold(c);
+                }
+            }
+            el.no_slash = _opts.pathname && el.kind != elem_kind::literal;
         }
+        return std::move(_elems);
     }
+};
+
+}  // namespace
+
+class btr::fnmatch_pattern::impl {
+    btr::u8string   _spelling;
+    fnmatch_options _opts;
+    pattern_matcher _matcher;
 
 public:
-    impl(u8view str_)
-        : _spelling(str_) {
-        if (_unicode.starts_with(U"!")) {
-            throw bad_fnmatch_pattern(_spelling,
-                                      "Patterns starting with a literal exclamation point '!' "
-                                      "are reserved. Escape with square brackets [!]");
-        }
-        _compile_next(_unicode);
-        // Set the tail of the list to be an rt_end to detect end-of-string
-        _add_elem<rt_end>();
-    }
+    impl(u8view str_, const fnmatch_options& opts)
+        : _spelling(str_)
+        , _opts(opts)
+        , _matcher(pattern_parser{_spelling, _opts}.parse(), _opts) {}
 
-    bool match(u8_iter first, u8_iter last) const noexcept {
-        assert(_head);
-        return _head->match(first, last) == yes;
+    bool match(std::u8string_view str, bool known_valid = false) const noexcept {
+        return _matcher.match(str, known_valid);
     }
 
-    bool match(auto range) const {
-        assert(_head);
-        return _head->match(range.begin(), range.end());
+    std::size_t match_many(std::span<const u8view> strings,
+                           std::span<bool>         results) const noexcept {
+        return _matcher.match_many(strings, results);
     }
 
-    const std::string& spelling() const noexcept { return _spelling; }
+    const btr::u8string&   spelling() const noexcept { return _spelling; }
+    const shape_info&      shape() const noexcept { return _matcher.shape(); }
+    const fnmatch_options& options() const noexcept { return _opts; }
 };
 
-btr::fnmatch_pattern btr::fnmatch_pattern::compile(u8view pat) {
-    return fnmatch_pattern{std::make_shared<impl>(pat)};
+btr::fnmatch_pattern btr::fnmatch_pattern::compile(u8view pat, const fnmatch_options& opts) {
+    return fnmatch_pattern{std::make_shared<impl>(pat, opts)};
 }
 
-const std::string& btr::fnmatch_pattern::literal_spelling() const noexcept {
+const btr::u8string& btr::fnmatch_pattern::literal_spelling() const noexcept {
     assert(_impl);
     return _impl->spelling();
 }
 
+btr::fnmatch_shape btr::fnmatch_pattern::shape() const noexcept {
+    assert(_impl);
+    return _impl->shape().shape;
+}
+
+const btr::fnmatch_options& btr::fnmatch_pattern::options() const noexcept {
+    assert(_impl);
+    return _impl->options();
+}
+
+const std::string& btr::fnmatch_pattern::literal_prefix() const noexcept {
+    assert(_impl);
+    return _impl->shape().prefix;
+}
+
+const std::string& btr::fnmatch_pattern::literal_suffix() const noexcept {
+    assert(_impl);
+    return _impl->shape().suffix;
+}
+
 btr::bad_fnmatch_pattern::bad_fnmatch_pattern(std::string pat, std::string reason) noexcept
     : runtime_error{neo::ufmt("The given fnmatch pattern string '{}' is invalid: {}", pat, reason)}
     , _pat(std::move(pat))
@@ -275,6 +1012,175 @@ btr::bad_fnmatch_pattern::bad_fnmatch_pattern(std::string pat, std::string reaso
 
 bool btr::fnmatch_pattern::_test(u8view sv) const noexcept {
     assert(_impl);
-    btr::codepoint_range chars{sv.u8string_view()};
-    return _impl->match(chars.begin(), chars.end());
+    return _impl->match(sv.u8string_view());
+}
+
+bool btr::fnmatch_pattern::test(valid_u8view str) const noexcept {
+    assert(_impl);
+    return _impl->match(str.u8string_view(), true);
+}
+
+std::size_t btr::fnmatch_pattern::test_many(std::span<const u8view> strings,
+                                            std::span<bool>         results) const noexcept {
+    assert(_impl);
+    neo_assert(expects,
+               strings.size() == results.size(),
+               "test_many() requires an output span of the same size as the input span",
+               strings.size(),
+               results.size());
+    return _impl->match_many(strings, results);
+}
+
+namespace {
+
+/// A map from a literal string to the indices of the patterns that are matched by that string
+using pattern_index_map = std::unordered_map<std::string_view, std::vector<std::size_t>>;
+
+}  // namespace
+
+class btr::fnmatch_set::impl {
+    std::vector<btr::u8string> _spellings;
+    fnmatch_options            _opts;
+    /// Patterns of the 'exact' shape, keyed by their spelling
+    pattern_index_map _exact;
+    /// Patterns of the 'extension' shape, keyed by their extension (including the period)
+    pattern_index_map _by_extension;
+    /// Patterns of the 'always' shape
+    std::vector<std::size_t> _always;
+    /// Whether any patterns are matched by the automaton
+    bool _has_residual = false;
+    /// Every other pattern, compiled together
+    automaton _automaton;
+
+    /**
+     * Parse and classify each pattern. Patterns of a shape that can be matched by a hash lookup are
+     * added to the index, and the elements of every other pattern are concatenated to form the
+     * automaton. The index compares bytes exactly, so it is not used if any options are given.
+     */
+    std::vector<pattern_elem> _partition() {
+        const bool use_index = !_opts.case_insensitive && !_opts.leading_period && !_opts.pathname;
+
+        std::vector<pattern_elem> residual;
+        for (std::size_t idx = 0; idx < _spellings.size(); ++idx) {
+            auto elems = pattern_parser{_spellings[idx], _opts}.parse();
+            auto shape = use_index ? classify(elems) : shape_info{};
+            // The text of an exact pattern is its spelling, and the extension of an extension
+            // pattern is the tail of its spelling, so the keys can view the stored spellings.
+            const std::string_view spelling = _spellings[idx].string_view();
+            if (shape.shape == fnmatch_shape::exact) {
+                _exact[spelling].push_back(idx);
+            } else if (shape.shape == fnmatch_shape::extension) {
+                auto ext = spelling.substr(spelling.size() - shape.suffix.size());
+                _by_extension[ext].push_back(idx);
+            } else if (shape.shape == fnmatch_shape::always) {
+                _always.push_back(idx);
+            } else {
+                elems.back().pattern_index = static_cast<std::uint32_t>(idx);
+                residual.insert(residual.end(),
+                                std::make_move_iterator(elems.begin()),
+                                std::make_move_iterator(elems.end()));
+                _has_residual = true;
+            }
+        }
+        return residual;
+    }
+
+    /// Invoke `fn` with the indices of each group of indexed patterns that match the string
+    void _for_each_indexed(std::u8string_view str, auto&& fn) const {
+        const auto sv = std::string_view(reinterpret_cast<const char*>(str.data()), str.size());
+        if (auto found = _exact.find(sv); found != _exact.end()) {
+            fn(found->second);
+        }
+        if (_by_extension.empty() && _always.empty()) {
+            return;
+        }
+        if (!validate_utf8(str)) {
+            return;
+        }
+        if (auto dot = sv.rfind('.'); dot != sv.npos) {
+            if (auto found = _by_extension.find(sv.substr(dot)); found != _by_extension.end()) {
+                fn(found->second);
+            }
+        }
+        if (!_always.empty()) {
+            fn(_always);
+        }
+    }
+
+public:
+    impl(std::vector<btr::u8string> spellings, const fnmatch_options& opts)
+        : _spellings(std::move(spellings))
+        , _opts(opts)
+        , _automaton(_partition(), _opts) {}
+
+    const std::vector<btr::u8string>& spellings() const noexcept { return _spellings; }
+
+    bool match_any(std::u8string_view str) const noexcept {
+        bool found = false;
+        _for_each_indexed(str, [&](auto&&) { found = true; });
+        return found || (_has_residual && _automaton.accepts(_automaton.start(), str, true));
+    }
+
+    std::optional<std::size_t> first_match(std::u8string_view str) const noexcept {
+        std::optional<std::size_t> ret;
+        if (_has_residual) {
+            ret = _automaton.first_match(str);
+        }
+        _for_each_indexed(str, [&](const std::vector<std::size_t>& indices) {
+            // Each group of indices is in ascending order
+            ret = ret ? (std::min)(*ret, indices.front()) : indices.front();
+        });
+        return ret;
+    }
+
+    void matches(std::u8string_view str, std::vector<std::size_t>& out) const {
+        out.clear();
+        if (_has_residual) {
+            _automaton.matches(str, out);
+        }
+        const auto n_residual = out.size();
+        _for_each_indexed(str, [&](const std::vector<std::size_t>& indices) {
+            out.insert(out.end(), indices.begin(), indices.end());
+        });
+        if (out.size() != n_residual) {
+            std::ranges::sort(out);
+        }
+    }
+};
+
+btr::fnmatch_set btr::fnmatch_set::_compile(std::vector<btr::u8string> patterns,
+                                             const fnmatch_options&     opts) {
+    neo_assert(expects,
+               patterns.size() <= UINT32_MAX,
+               "Too many patterns given to fnmatch_set::compile()",
+               patterns.size());
+    fnmatch_set ret;
+    ret._impl = std::make_shared<impl>(std::move(patterns), opts);
+    return ret;
+}
+
+std::size_t btr::fnmatch_set::size() const noexcept {
+    assert(_impl);
+    return _impl->spellings().size();
+}
+
+const btr::u8string& btr::fnmatch_set::literal_spelling(std::size_t idx) const noexcept {
+    assert(_impl);
+    assert(idx < size());
+    return _impl->spellings()[idx];
+}
+
+bool btr::fnmatch_set::test(u8view str) const noexcept {
+    assert(_impl);
+    return _impl->match_any(str.u8string_view());
+}
+
+std::optional<std::size_t> btr::fnmatch_set::first_match(u8view str) const noexcept {
+    assert(_impl);
+    return _impl->first_match(str.u8string_view());
+}
+
+void btr::fnmatch_set::matches(u8view str, std::vector<std::size_t>& out) const {
+    assert(_impl);
+    _impl->matches(str.u8string_view(), out);
 }
@@ -1,11 +1,17 @@
 #pragma once
 
+#include "./u8string.hpp"
 #include "./u8view.hpp"
 #include "./utf.hpp"
 
+#include <initializer_list>
 #include <memory>
+#include <optional>
 #include <ranges>
+#include <span>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 namespace btr {
 
@@ -31,6 +37,54 @@ public:
     const std::string& reason() const noexcept { return _reason; }
 };
 
+/**
+ * @brief The general form of an fnmatch pattern.
+ *
+ * Patterns of every shape other than `general` consist only of literal characters and at most one
+ * star, and are matched by comparing the literal prefix and suffix of the pattern.
+ */
+enum class fnmatch_shape {
+    /// A pattern with no wildcards, e.g. `main.cpp`
+    exact,
+    /// A literal prefix followed by a star, e.g. `main.*`
+    prefix,
+    /// A star followed by a literal suffix, e.g. `*_test.cpp`
+    suffix,
+    /// A star followed by a literal suffix that begins with a period and contains no other period,
+    /// e.g. `*.cpp`. A string matches if it is the same as the text following the final period.
+    extension,
+    /// A literal prefix and a literal suffix with a star between, e.g. `lib*.so`
+    prefix_suffix,
+    /// A single star, which matches any string
+    always,
+    /// Any other pattern
+    general,
+};
+
+/**
+ * @brief Options that modify how an fnmatch pattern matches strings
+ */
+struct fnmatch_options {
+    /**
+     * @brief Compare codepoints without regard to case (like FNM_CASEFOLD).
+     *
+     * Codepoints are compared after simple Unicode case folding (see btr::simple_case_fold()).
+     */
+    bool case_insensitive = false;
+    /**
+     * @brief A period '.' at the start of the string may only be matched by a literal period in
+     * the pattern, and not by a wildcard or a [group] (like FNM_PERIOD).
+     *
+     * With `pathname`, this also applies to a period immediately following a slash.
+     */
+    bool leading_period = false;
+    /**
+     * @brief A slash '/' in the string may only be matched by a literal slash in the pattern, and
+     * not by a wildcard or a [group] (like FNM_PATHNAME).
+     */
+    bool pathname = false;
+};
+
 /**
  * @brief A pre-compiled fnmatch pattern
  */
@@ -61,11 +115,138 @@ public:
         }
     }
 
+    /**
+     * @brief Test whether the given string matches the compiled fnmatch pattern.
+     *
+     * The string is known to be valid UTF-8, so it is not validated again, and is decoded without
+     * checking for errors.
+     */
+    [[nodiscard]] bool test(valid_u8view string) const noexcept;
+
+    /**
+     * @brief Test each of the given strings against the compiled pattern.
+     *
+     * This is equivalent to calling test() on each string, but amortizes the per-call overhead and
+     * rejects strings with the wrong length, prefix, or suffix in a single pass before running the
+     * full matcher.
+     *
+     * @param strings The strings to test.
+     * @param results Receives the result of each test. Must be the same size as `strings`.
+     * @return The number of strings that match the pattern
+     */
+    std::size_t test_many(std::span<const u8view> strings, std::span<bool> results) const noexcept;
+
+    /**
+     * @brief Obtain a view of the strings in the given range that match the compiled pattern.
+     *
+     * @param strings A viewable range of strings or string-like ranges.
+     */
+    template <std::ranges::viewable_range R>
+    [[nodiscard]] auto filter(R&& strings) const {
+        return std::views::filter(std::forward<R>(strings),
+                                  [pattern = *this](const auto& str) { return pattern.test(str); });
+    }
+
     /// Get the original spelling of the pattern
-    [[nodiscard]] const std::string& literal_spelling() const noexcept;
+    [[nodiscard]] const btr::u8string& literal_spelling() const noexcept;
+
+    /// Get the shape of the pattern
+    [[nodiscard]] fnmatch_shape shape() const noexcept;
+
+    /**
+     * @brief Get the literal text that every matching string must begin with.
+     *
+     * For an `exact` pattern, this is the entire text to match. If the pattern is case-insensitive,
+     * the text is case-folded.
+     */
+    [[nodiscard]] const std::string& literal_prefix() const noexcept;
+
+    /**
+     * @brief Get the literal text that every matching string must end with.
+     *
+     * For an `extension` pattern, this is the extension (including the period). For an `exact`
+     * pattern, this is the entire text to match.
+     */
+    [[nodiscard]] const std::string& literal_suffix() const noexcept;
+
+    /// Get the options that were used to compile the pattern
+    [[nodiscard]] const fnmatch_options& options() const noexcept;
 
-    /// Compile the given fnmatch pattern
-    [[nodiscard]] static fnmatch_pattern compile(u8view fnmatch_pattern);
+    /// Compile the given fnmatch pattern, with the given options
+    [[nodiscard]] static fnmatch_pattern compile(u8view                 fnmatch_pattern,
+                                                 const fnmatch_options& opts = {});
+};
+
+/**
+ * @brief A set of fnmatch patterns that are compiled together, so that a string can be tested
+ * against every pattern of the set in a single pass.
+ *
+ * Patterns are identified by their index within the sequence given to compile(). Patterns with an
+ * `exact`, `extension`, or `always` shape are matched by hash lookup, and all other patterns are
+ * compiled into a single automaton.
+ */
+class fnmatch_set {
+    class impl;
+    std::shared_ptr<const impl> _impl;
+
+    static fnmatch_set _compile(std::vector<btr::u8string> patterns, const fnmatch_options& opts);
+
+public:
+    /**
+     * @brief Compile a new fnmatch_set from the given sequence of patterns.
+     *
+     * @param patterns The patterns of the set
+     * @param opts Options that apply to every pattern in the set
+     *
+     * @throws bad_fnmatch_pattern if any pattern is not a valid fnmatch() pattern
+     */
+    [[nodiscard]] static fnmatch_set compile(std::initializer_list<u8view> patterns,
+                                             const fnmatch_options&        opts = {}) {
+        std::vector<btr::u8string> vec;
+        for (u8view pat : patterns) {
+            vec.emplace_back(pat);
+        }
+        return _compile(std::move(vec), opts);
+    }
+
+    /// @copydoc compile(std::initializer_list<u8view>, const fnmatch_options&)
+    template <std::ranges::input_range R>
+    requires std::convertible_to<std::ranges::range_reference_t<R>, u8view>  //
+        [[nodiscard]] static fnmatch_set compile(R&& patterns, const fnmatch_options& opts = {}) {
+        std::vector<btr::u8string> vec;
+        for (u8view pat : patterns) {
+            vec.emplace_back(pat);
+        }
+        return _compile(std::move(vec), opts);
+    }
+
+    /// Get the number of patterns in the set
+    [[nodiscard]] std::size_t size() const noexcept;
+
+    /// Get the original spelling of the pattern at the given index
+    [[nodiscard]] const btr::u8string& literal_spelling(std::size_t idx) const noexcept;
+
+    /// Test whether any pattern in the set matches the given string
+    [[nodiscard]] bool test(u8view string) const noexcept;
+
+    /// Get the lowest index of a pattern that matches the given string, if any
+    [[nodiscard]] std::optional<std::size_t> first_match(u8view string) const noexcept;
+
+    /**
+     * @brief Obtain the indices of every pattern that matches the given string.
+     *
+     * @param string The string to test
+     * @param out Receives the indices of the matching patterns, in ascending order. The vector is
+     *      cleared before use, but its storage is reused.
+     */
+    void matches(u8view string, std::vector<std::size_t>& out) const;
+
+    /// Obtain the indices of every pattern that matches the given string, in ascending order
+    [[nodiscard]] std::vector<std::size_t> matches(u8view string) const {
+        std::vector<std::size_t> ret;
+        matches(string, ret);
+        return ret;
+    }
 };
 
 /**
@@ -76,11 +257,21 @@ public:
  * @return true If the string matches the pattern
  * @return false Otherwise
  *
- * @note To reduce overhead of compiling and parsing `pattern` repeatedly, use
- *      `btr::fnmatch_pattern::compile()` to pre-compile the pattern.
+ * @note Compiled patterns are kept in btr::pattern_cache::global(), so repeated calls with the
+ *      same pattern do not need to parse it again. Use `btr::fnmatch_pattern::compile()` to
+ *      pre-compile the pattern and avoid the cache lookup entirely.
+ */
+[[nodiscard]] bool fnmatch(u8view pattern, u8view string);
+
+/**
+ * @brief Test whether the given @param string matches @param pattern with the given options
+ *
+ * @param pattern The pattern to check against.
+ * @param string The string to test
+ * @param opts Options that modify the matching behavior
+ *
+ * @note As above, compiled patterns are kept in btr::pattern_cache::global().
  */
-[[nodiscard]] inline bool fnmatch(u8view pattern, u8view string) {
-    return fnmatch_pattern::compile(pattern).test(string.u8string_view());
-}
+[[nodiscard]] bool fnmatch(u8view pattern, u8view string, const fnmatch_options& opts);
 
 }  // namespace btr
@@ -2,6 +2,19 @@
 
 #include <catch2/catch.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if !_WIN32
+#include <fnmatch.h>
+#endif
+
 TEST_CASE("Basic fnmatch matching") {
     auto pat = btr::fnmatch_pattern::compile("foo.bar");
     CHECK_FALSE(pat.test("foo.baz"));
@@ -67,6 +80,9 @@ TEST_CASE("Cases") {
         {true, "Кири[лabc]лица", "Кириaлица"},      // Unicode
         {false, "Кири[!л]лица", "Кириллица"},       // Unicode
         {true, "Кири[!л]лица", "Кириqлица"},        // Unicode
+        {true, "*.txt", "файл.txt"},                // Unicode input, ASCII pattern
+        {true, "?.txt", "ф.txt"},                   // Unicode input, ASCII pattern
+        {false, "[!ф]", "ф"},                       // Unicode input, Unicode group
 
         {true, "[?]", "?"},    // Escape via grouping
         {true, "[?]?", "?f"},  // Escape via grouping
@@ -104,3 +120,388 @@ TEST_CASE("Cases") {
     const bool did_match = pat.test(test_str);
     CHECK(did_match == expect_match);
 }
+
+TEST_CASE("Bad patterns") {
+    CHECK_THROWS_AS(btr::fnmatch_pattern::compile("!foo"), btr::bad_fnmatch_pattern);
+    CHECK_THROWS_AS(btr::fnmatch_pattern::compile("foo[abc"), btr::bad_fnmatch_pattern);
+    CHECK_THROWS_AS(btr::fnmatch_pattern::compile("foo["), btr::bad_fnmatch_pattern);
+}
+
+TEST_CASE("Invalid UTF-8 never matches") {
+    auto pat = btr::fnmatch_pattern::compile("*");
+    CHECK_FALSE(pat.test(std::string_view("foo\xff")));
+    pat = btr::fnmatch_pattern::compile("foo?");
+    CHECK_FALSE(pat.test(std::string_view("foo\xc3")));
+}
+
+TEST_CASE("Match pre-validated strings") {
+    const std::string_view strings[]
+        = {"foo.cpp", "bar.hpp", "фу.cpp", "ж", "ＦＯＯ.cpp", ""};
+    for (auto pat_str : {"*.cpp", "?", "*", "ф*", "[!a]*.cpp", "*o*", "ｆ*"}) {
+        for (auto opts : {btr::fnmatch_options{}, btr::fnmatch_options{.case_insensitive = true}}) {
+            const auto pat = btr::fnmatch_pattern::compile(pat_str, opts);
+            for (auto str : strings) {
+                CAPTURE(pat_str, str);
+                CHECK(pat.test(btr::valid_u8view{str}) == pat.test(str));
+            }
+        }
+    }
+}
+
+namespace {
+
+// A simple backtracking matcher, used as a reference for the compiled matcher
+bool reference_match(std::string_view pat, std::string_view str) {
+    if (pat.empty()) {
+        return str.empty();
+    }
+    if (pat[0] == '*') {
+        for (std::size_t n = 0; n <= str.size(); ++n) {
+            if (reference_match(pat.substr(1), str.substr(n))) {
+                return true;
+            }
+        }
+        return false;
+    }
+    if (str.empty()) {
+        return false;
+    }
+    if (pat[0] == '[') {
+        const bool negate = pat[1] == '!';
+        auto       close  = pat.find(']', 2);
+        auto       chars  = pat.substr(negate ? 2 : 1, close - (negate ? 2 : 1));
+        const bool found  = chars.find(str[0]) != chars.npos;
+        return found != negate && reference_match(pat.substr(close + 1), str.substr(1));
+    }
+    return (pat[0] == '?' || pat[0] == str[0]) && reference_match(pat.substr(1), str.substr(1));
+}
+
+}  // namespace
+
+TEST_CASE("Compare against a reference matcher") {
+    const std::string_view tokens[] = {"a", "b", "*", "?", "[ab]", "[!a]"};
+    const std::string_view chars    = "abc";
+
+    std::uint32_t seed = 42;
+    auto          rand = [&](std::uint32_t n) {
+        seed = seed * 1664525 + 1013904223;
+        return (seed >> 8) % n;
+    };
+
+    for (int i = 0; i < 2000; ++i) {
+        std::string pat_str;
+        for (auto n = rand(7); n; --n) {
+            pat_str.append(tokens[rand(6)]);
+        }
+        const auto pat = btr::fnmatch_pattern::compile(pat_str);
+        for (int j = 0; j < 10; ++j) {
+            std::string str;
+            for (auto n = rand(13); n; --n) {
+                str.push_back(chars[rand(3)]);
+            }
+            CAPTURE(pat_str, str);
+            CHECK(pat.test(str) == reference_match(pat_str, str));
+        }
+    }
+}
+
+TEST_CASE("Match many strings at once") {
+    const std::vector<std::string> strings = {
+        "foo.cpp",
+        "foo.hpp",
+        "main.cpp",
+        ".cpp",
+        "cpp",
+        "foo.cpp.txt",
+        "a-very-long-file-name.cpp",
+        "ファイル.cpp",
+        "foo.c",
+        "",
+    };
+    const std::vector<btr::u8view> views(strings.begin(), strings.end());
+
+    for (auto pat_str : {"*.cpp", "foo.*", "*", "f*p", "*.?pp", "main.cpp", "*cpp*", "ファ*"}) {
+        const auto pat       = btr::fnmatch_pattern::compile(pat_str);
+        auto       results   = std::make_unique<bool[]>(strings.size());
+        auto       n_matched = pat.test_many(views, std::span(results.get(), strings.size()));
+        std::size_t n_expected = 0;
+        for (std::size_t i = 0; i < strings.size(); ++i) {
+            CAPTURE(pat_str, strings[i]);
+            CHECK(bool(results[i]) == pat.test(strings[i]));
+            n_expected += pat.test(strings[i]) ? 1 : 0;
+        }
+        CHECK(n_matched == n_expected);
+    }
+
+    auto pat     = btr::fnmatch_pattern::compile("*.cpp");
+    auto matched = pat.filter(strings);
+    CHECK(std::vector<std::string>(matched.begin(), matched.end())
+          == std::vector<std::string>{"foo.cpp", "main.cpp", ".cpp", "a-very-long-file-name.cpp",
+                                      "ファイル.cpp"});
+}
+
+TEST_CASE("Match against a set of patterns") {
+    const auto set = btr::fnmatch_set::compile({"*.cpp", "*.hpp", "main.*", "*~", "ファ*"});
+    CHECK(set.size() == 5);
+    CHECK(set.literal_spelling(2) == "main.*");
+
+    CHECK(set.test("foo.cpp"));
+    CHECK_FALSE(set.test("foo.txt"));
+    CHECK(set.first_match("main.cpp") == 0);
+    CHECK(set.first_match("main.txt") == 2);
+    CHECK(set.first_match("foo.txt") == std::nullopt);
+    CHECK(set.matches("main.cpp") == std::vector<std::size_t>{0, 2});
+    CHECK(set.matches("main.hpp~") == std::vector<std::size_t>{2, 3});
+    CHECK(set.matches("ファイル.cpp") == std::vector<std::size_t>{0, 4});
+    CHECK(set.matches("foo").empty());
+
+    const auto empty = btr::fnmatch_set::compile(std::vector<std::string>{});
+    CHECK_FALSE(empty.test(""));
+    CHECK_FALSE(empty.test("foo"));
+
+    CHECK_THROWS_AS(btr::fnmatch_set::compile({"*.cpp", "[foo"}), btr::bad_fnmatch_pattern);
+}
+
+TEST_CASE("Compare a set of patterns against individual patterns") {
+    const std::string_view tokens[] = {"a", ".", "*", "?", "[ab]", "[!a]"};
+    const std::string_view chars    = "a.c";
+
+    std::uint32_t seed = 1729;
+    auto          rand = [&](std::uint32_t n) {
+        seed = seed * 1664525 + 1013904223;
+        return (seed >> 8) % n;
+    };
+
+    for (int i = 0; i < 50; ++i) {
+        std::vector<std::string> pat_strs;
+        for (auto n = rand(40); n; --n) {
+            auto& pat_str = pat_strs.emplace_back();
+            for (auto len = rand(6) + 1; len; --len) {
+                pat_str.append(tokens[rand(6)]);
+            }
+        }
+        const auto set = btr::fnmatch_set::compile(pat_strs);
+        for (int j = 0; j < 50; ++j) {
+            std::string str;
+            for (auto n = rand(9); n; --n) {
+                str.push_back(chars[rand(3)]);
+            }
+            std::vector<std::size_t> expect;
+            for (std::size_t idx = 0; idx < pat_strs.size(); ++idx) {
+                if (btr::fnmatch(pat_strs[idx], str)) {
+                    expect.push_back(idx);
+                }
+            }
+            CAPTURE(str);
+            CHECK(set.matches(str) == expect);
+            CHECK(set.test(str) == !expect.empty());
+            CHECK(set.first_match(str)
+                  == (expect.empty() ? std::nullopt : std::optional<std::size_t>(expect.front())));
+        }
+    }
+}
+
+TEST_CASE("Classify pattern shapes") {
+    struct case_ {
+        std::string_view   pattern;
+        btr::fnmatch_shape shape;
+        std::string_view   prefix;
+        std::string_view   suffix;
+    };
+    auto [pat_str, shape, prefix, suffix] = GENERATE(Catch::Generators::values<case_>({
+        {"main.cpp", btr::fnmatch_shape::exact, "main.cpp", "main.cpp"},
+        {"", btr::fnmatch_shape::exact, "", ""},
+        {"main.*", btr::fnmatch_shape::prefix, "main.", ""},
+        {"*_test.cpp", btr::fnmatch_shape::suffix, "", "_test.cpp"},
+        {"*.tar.gz", btr::fnmatch_shape::suffix, "", ".tar.gz"},
+        {"*.cpp", btr::fnmatch_shape::extension, "", ".cpp"},
+        {"*.ファイル", btr::fnmatch_shape::extension, "", ".ファイル"},
+        {"lib*.so", btr::fnmatch_shape::prefix_suffix, "lib", ".so"},
+        {"*", btr::fnmatch_shape::always, "", ""},
+        {"**", btr::fnmatch_shape::always, "", ""},
+        {"*.?pp", btr::fnmatch_shape::general, "", "pp"},
+        {"a*b*c", btr::fnmatch_shape::general, "a", "c"},
+        {"[ab]", btr::fnmatch_shape::general, "", ""},
+    }));
+    auto pat = btr::fnmatch_pattern::compile(pat_str);
+    CAPTURE(pat_str);
+    CHECK(pat.shape() == shape);
+    CHECK(pat.literal_prefix() == prefix);
+    CHECK(pat.literal_suffix() == suffix);
+}
+
+TEST_CASE("Match with options") {
+    struct case_ {
+        bool                 expect_match;
+        std::string_view     pattern;
+        std::string_view     string;
+        btr::fnmatch_options opts;
+    };
+    const btr::fnmatch_options nocase{.case_insensitive = true};
+    const btr::fnmatch_options period{.leading_period = true};
+    const btr::fnmatch_options pathname{.pathname = true};
+    const btr::fnmatch_options path_period{.leading_period = true, .pathname = true};
+
+    auto [expect_match, pat_str, test_str, opts] = GENERATE_COPY(Catch::Generators::values<case_>({
+        {true, "*.CPP", "foo.cpp", nocase},
+        {true, "*.cpp", "FOO.CPP", nocase},
+        {false, "*.cpp", "FOO.CPP", {}},
+        {true, "main.cpp", "Main.Cpp", nocase},
+        {true, "[AB]x", "bX", nocase},
+        {false, "[!AB]x", "bX", nocase},
+        {true, "ФАЙЛ.txt", "файл.TXT", nocase},
+        {true, "straße", "STRAßE", nocase},
+        {true, "k", "K", nocase},  // KELVIN SIGN
+        {true, "*", ".hidden", {}},
+        {false, "*", ".hidden", period},
+        {false, "?hidden", ".hidden", period},
+        {false, "[.]hidden", ".hidden", period},
+        {true, ".*", ".hidden", period},
+        {false, "*.cpp", ".cpp", period},
+        {true, "a*", "a.b", period},
+        {true, "*", "a/.b", period},
+        {false, "*", "a/b", pathname},
+        {true, "a/*", "a/b", pathname},
+        {false, "a?b", "a/b", pathname},
+        {false, "a[!x]b", "a/b", pathname},
+        {true, "*/*", "a/b", pathname},
+        {true, "a/*", "a/.b", pathname},
+        {false, "a/*", "a/.b", path_period},
+        {true, "a/.*", "a/.b", path_period},
+        {false, "*/b", ".a/b", path_period},
+        {true, ".a/b", ".a/b", path_period},
+        {true, ".a/*.txt", ".a/b.txt", path_period},
+        {false, ".a/*.txt", ".a/.b.txt", path_period},
+    }));
+    INFO("Matching pattern '" << pat_str << "' against string '" << test_str << "'");
+    auto pattern = btr::fnmatch_pattern::compile(pat_str, opts);
+    CHECK(pattern.test(test_str) == expect_match);
+    CHECK(btr::fnmatch_set::compile({pat_str}, opts).test(test_str) == expect_match);
+}
+
+#if !_WIN32
+TEST_CASE("Compare options against POSIX fnmatch()") {
+    const std::string_view tokens[] = {"a", "A", ".", "/", "*", "?", "[a.]", "[!a]"};
+    const std::string_view chars    = "aA./";
+
+    std::uint32_t seed = 31337;
+    auto          rand = [&](std::uint32_t n) {
+        seed = seed * 1664525 + 1013904223;
+        return (seed >> 8) % n;
+    };
+
+    for (int i = 0; i < 2000; ++i) {
+        std::string pat_str;
+        for (auto n = rand(7); n; --n) {
+            pat_str.append(tokens[rand(8)]);
+        }
+        const int                  posix_flags = static_cast<int>(rand(8));
+        const btr::fnmatch_options opts{
+            .case_insensitive = (posix_flags & 1) != 0,
+            .leading_period   = (posix_flags & 2) != 0,
+            .pathname         = (posix_flags & 4) != 0,
+        };
+        const int flags = ((posix_flags & 1) ? FNM_CASEFOLD : 0)
+            | ((posix_flags & 2) ? FNM_PERIOD : 0) | ((posix_flags & 4) ? FNM_PATHNAME : 0);
+        const auto pat = btr::fnmatch_pattern::compile(pat_str, opts);
+        for (int j = 0; j < 10; ++j) {
+            std::string str;
+            for (auto n = rand(9); n; --n) {
+                str.push_back(chars[rand(4)]);
+            }
+            CAPTURE(pat_str, str, posix_flags);
+            CHECK(pat.test(str) == (::fnmatch(pat_str.c_str(), str.c_str(), flags) == 0));
+        }
+    }
+}
+#endif
+
+TEST_CASE("Match from many threads") {
+    const auto pat = btr::fnmatch_pattern::compile("*a?????b*");
+
+    std::vector<std::string> strings;
+    for (int i = 0; i < 4096; ++i) {
+        std::string s;
+        for (int bit = 0; bit < 12; ++bit) {
+            s.push_back((i >> bit) & 1 ? 'a' : 'b');
+        }
+        strings.push_back(s);
+    }
+
+    auto count_matches = [&] {
+        return std::ranges::count_if(strings, [&](auto& s) { return pat.test(s); });
+    };
+    const auto expect = count_matches();
+
+    std::vector<std::thread> threads;
+    std::atomic<int>         n_agree = 0;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&] {
+            if (count_matches() == expect) {
+                ++n_agree;
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    CHECK(n_agree == 4);
+}
+
+TEST_CASE("Patterns with many automaton states") {
+    // This pattern requires one automaton state for every combination of the last eleven chars
+    const std::string_view pat_str = "*a??????????";
+    const auto             pat     = btr::fnmatch_pattern::compile(pat_str);
+    // The second pass runs entirely after the limit on automaton states has been reached
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int i = 0; i < 8192; ++i) {
+            std::string s;
+            for (int bit = 0; bit < 13; ++bit) {
+                s.push_back((i >> bit) & 1 ? 'a' : 'b');
+            }
+            CAPTURE(pass, s);
+            CHECK(pat.test(s) == reference_match(pat_str, s));
+        }
+    }
+}
+
+TEST_CASE("Adversarial patterns") {
+    // Each of these would require exponential or quadratic time from a backtracking matcher. The
+    // automaton must process them in time linear in the length of the input.
+    const std::string many_a(100'000, 'a');
+    auto              pat = btr::fnmatch_pattern::compile("*a*a*a*a*a*a*a*a*a*a*b");
+    CHECK_FALSE(pat.test(many_a));
+    CHECK(pat.test(many_a + "b"));
+
+    // Patterns with many positions span more than one word of the position sets
+    std::string long_pat;
+    for (int i = 0; i < 40; ++i) {
+        long_pat += "*a";
+    }
+    pat = btr::fnmatch_pattern::compile(long_pat + "*b");
+    CHECK_FALSE(pat.test(many_a));
+    CHECK(pat.test(many_a + "b"));
+    CHECK_FALSE(pat.test(std::string(39, 'a') + "b"));
+    CHECK(pat.test(std::string(40, 'a') + "b"));
+
+    // This pattern exceeds the limit on the number of automaton states, so the input must be
+    // matched by simulating the automaton directly
+    pat = btr::fnmatch_pattern::compile("*a??????????????????????????????*b");
+    std::string alternating;
+    for (int i = 0; i < 100'000; ++i) {
+        alternating.push_back(i % 3 ? 'a' : 'c');
+    }
+    CHECK_FALSE(pat.test(alternating));
+    CHECK(pat.test(alternating + "b"));
+    CHECK_FALSE(pat.test(alternating.substr(0, 30) + "b"));
+
+    // The same, with non-ASCII input and options
+    pat = btr::fnmatch_pattern::compile("*é*É*é*É*é*É*x", {.case_insensitive = true});
+    std::string many_e;
+    for (int i = 0; i < 50'000; ++i) {
+        many_e += "é";
+    }
+    CHECK_FALSE(pat.test(many_e));
+    CHECK(pat.test(many_e + "X"));
+    CHECK_FALSE(pat.test("éééééx"));
+}
@@ -8,6 +8,10 @@
 #include <set>
 #include <variant>
 
+#if !_WIN32
+#include <sys/stat.h>
+#endif
+
 using namespace btr;
 namespace fs    = std::filesystem;
 using path_iter = fs::path::const_iterator;
@@ -106,10 +110,65 @@ bool glob::test(const fs::path& filepath) const noexcept {
                                 _impl->elements.cend());
 }
 
+std::optional<glob_detail::dir_identity>
+glob_detail::get_dir_identity(const fs::path& dirpath) noexcept {
+#if !_WIN32
+    struct ::stat st;
+    if (::stat(dirpath.c_str(), &st) != 0) {
+        return std::nullopt;
+    }
+    return dir_identity{static_cast<std::uint64_t>(st.st_dev),
+                        static_cast<std::uint64_t>(st.st_ino)};
+#else
+    // Windows does not expose a cheap (dev, inode) pair through a path. Use the hash of the
+    // canonical path as a stand-in.
+    std::error_code ec;
+    auto            canon = fs::canonical(dirpath, ec);
+    if (ec) {
+        return std::nullopt;
+    }
+    return dir_identity{0, static_cast<std::uint64_t>(fs::hash_value(canon))};
+#endif
+}
+
+bool glob_detail::should_descend(const glob_search_options& opts,
+                                 const fs::directory_entry& entry,
+                                 std::size_t                depth) {
+    std::error_code ec;
+    if (!entry.is_directory(ec)) {
+        return false;
+    }
+    if (!opts.follow_symlinks && entry.is_symlink(ec)) {
+        return false;
+    }
+    if (opts.max_depth && depth >= *opts.max_depth) {
+        return false;
+    }
+    if (opts.dotfiles == glob_dotfiles::exclude && is_dotfile_name(entry.path().filename())) {
+        return false;
+    }
+    if (opts.prune && opts.prune(entry)) {
+        return false;
+    }
+    return true;
+}
+
 struct glob::iterator::state {
     fs::path          my_root;
     const glob::impl& impl;
 
+    std::shared_ptr<const glob_search_options> opts;
+
+    /// The state that created this state, or nullptr if this is the root of the search
+    const state* parent = nullptr;
+    /// The depth of my_root beneath the search root
+    std::size_t depth = 0;
+
+    /// The identity of my_root, used to detect symlink cycles. Children are given the identity
+    /// that was checked before they were created.
+    std::optional<glob_detail::dir_identity> identity
+        = opts->follow_symlinks ? glob_detail::get_dir_identity(my_root) : std::nullopt;
+
     const impl::pattern_it pat_iter        = impl.elements.begin();
     const bool             is_leaf_pattern = std::next(pat_iter) == impl.elements.end();
 
@@ -133,6 +192,46 @@ struct glob::iterator::state {
         done,
     };
 
+    /// Whether the current entry is a dot-file that must be matched explicitly by a pattern
+    bool entry_needs_explicit_match() const noexcept {
+        return opts->dotfiles == glob_dotfiles::explicit_only
+            && glob_detail::is_dotfile_name(entry.path().filename());
+    }
+
+    /// Test whether the current entry's filename matches the given pattern element
+    bool entry_matches(const glob_element_type& pat) const {
+        if (entry_needs_explicit_match() && !as_fnmatch(pat).literal_spelling().starts_with(".")) {
+            return false;
+        }
+        return as_fnmatch(pat).test(fs::path(entry).filename().string());
+    }
+
+    /**
+     * Attempt to push a new state that will search the current entry with the given pattern.
+     * Returns 'false' if the search options or cycle detection forbid it.
+     */
+    bool try_descend(impl::pattern_it next_pat) {
+        if (!glob_detail::should_descend(*opts, entry, depth)) {
+            return false;
+        }
+        // Check for a cycle before the child opens the directory
+        std::optional<glob_detail::dir_identity> child_identity;
+        if (opts->follow_symlinks) {
+            child_identity = glob_detail::get_dir_identity(entry.path());
+            if (child_identity) {
+                for (const state* st = this; st; st = st->parent) {
+                    if (st->identity == child_identity) {
+                        // This directory is already being searched. We've found a symlink cycle.
+                        return false;
+                    }
+                }
+            }
+        }
+        next_state = std::unique_ptr<state>(
+            new state{entry, impl, opts, this, depth + 1, child_identity, next_pat});
+        return true;
+    }
+
     /**
      * Globbing is implemented as a simple coroutine.
      *
@@ -176,39 +275,57 @@ struct glob::iterator::state {
         // Inspect the next entry in the directory
         entry = *dir_iter++;
 
-        if (is_rglob(cur_pattern)) {
+        if (opts->dotfiles == glob_dotfiles::exclude
+            && glob_detail::is_dotfile_name(entry.path().filename())) {
+            // Skip this entry entirely
+        } else if (is_rglob(cur_pattern)) {
             // We are a '**' element.
-            if (is_leaf_pattern) {
+            if (entry_needs_explicit_match()) {
+                // A '**' never matches a dot-file that must be matched explicitly, but the next
+                // pattern might
+                if (!is_leaf_pattern && entry_matches(*next_pattern)) {
+                    if (entry.is_directory()) {
+                        if (try_descend(std::next(next_pattern))) {
+                            NEO_CORO_YIELD(reenter_again);
+                        }
+                    } else {
+                        NEO_CORO_YIELD(yield_value);
+                    }
+                }
+            } else if (is_leaf_pattern) {
                 // We are the final '**' element, so we match everything and should immediately
                 // yield what we just found
                 NEO_CORO_YIELD(yield_value);
-            } else if (as_fnmatch(*next_pattern).test(fs::path(entry).filename().string())) {
+            } else if (entry_matches(*next_pattern)) {
                 // We are not the final element, and the next pattern will match the entry we just
                 // found.
                 if (entry.is_directory()) {
                     // The entry is a directory, so we recurse into it.
-                    next_state.reset(new state{entry, impl, std::next(next_pattern)});
-                    NEO_CORO_YIELD(reenter_again);
+                    if (try_descend(std::next(next_pattern))) {
+                        NEO_CORO_YIELD(reenter_again);
+                    }
                 } else {
                     // The entry is a file, so yield that
                     NEO_CORO_YIELD(yield_value);
                 }
             }
-            if (entry.is_directory()) {
+            if (!entry_needs_explicit_match() && entry.is_directory()) {
                 // Recurse into directories
-                next_state.reset(new state{entry, impl, pat_iter});
-                NEO_CORO_YIELD(reenter_again);
+                if (try_descend(pat_iter)) {
+                    NEO_CORO_YIELD(reenter_again);
+                }
             } else {
                 // This is a non-directory file matching an '**' pattern. Ignore it
             }
         } else {
-            if (as_fnmatch(cur_pattern).test(fs::path(entry).filename().string())) {
+            if (entry_matches(cur_pattern)) {
                 // We match this entry
                 if (is_leaf_pattern) {
                     NEO_CORO_YIELD(yield_value);
                 } else if (entry.is_directory()) {
-                    next_state.reset(new state{entry, impl, next_pattern});
-                    NEO_CORO_YIELD(reenter_again);
+                    if (try_descend(next_pattern)) {
+                        NEO_CORO_YIELD(reenter_again);
+                    }
                 }
             }
         }
@@ -220,10 +337,13 @@ struct glob::iterator::state {
     }
 };
 
-glob::iterator::iterator(const glob& glb, const fs::path& dirpath)
+glob::iterator::iterator(const glob&                glb,
+                         const fs::path&            dirpath,
+                         const glob_search_options& opts)
     : _impl(glb._impl)
     , _done(false) {
-    _state = std::make_shared<state>(state{dirpath, *_impl});
+    _state = std::make_shared<state>(
+        state{dirpath, *_impl, std::make_shared<const glob_search_options>(opts)});
     increment();
 }
 
@@ -4,11 +4,90 @@
 
 #include <neo/iterator_facade.hpp>
 
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <optional>
 #include <vector>
 
 namespace btr {
 
+/**
+ * @brief Control how a directory search treats files and directories whose names begin with a
+ * period '.'
+ */
+enum class glob_dotfiles {
+    /// Dot-files are treated like any other file (the default)
+    include,
+    /// Dot-files are never yielded, and dot-directories are never searched
+    exclude,
+    /// Dot-files are only matched by pattern elements that themselves begin with a period. A '**'
+    /// will not recurse into dot-directories.
+    explicit_only,
+};
+
+/**
+ * @brief Options that control the traversal of a directory search
+ */
+struct glob_search_options {
+    /**
+     * @brief Whether the search should follow symbolic links to directories.
+     *
+     * If 'true' (the default), symlinked directories are searched as if they were regular
+     * directories. Links that would re-enter a directory that is already being searched (a cycle)
+     * are not followed.
+     */
+    bool follow_symlinks = true;
+
+    /**
+     * @brief The maximum depth of directories beneath the search root to search.
+     *
+     * A value of zero will only search the immediate contents of the root directory. If nullopt
+     * (the default), there is no depth limit.
+     */
+    std::optional<std::size_t> max_depth{};
+
+    /// How the search should treat names beginning with a period '.'
+    glob_dotfiles dotfiles = glob_dotfiles::include;
+
+    /**
+     * @brief A callback that is invoked for each directory before it is searched. If the callback
+     * returns 'true', that directory and its contents will not be searched.
+     */
+    std::function<bool(const std::filesystem::directory_entry&)> prune{};
+};
+
+namespace glob_detail {
+
+/// An identifier of a directory on the filesystem, used to detect symlink cycles
+struct dir_identity {
+    std::uint64_t device = 0;
+    std::uint64_t inode  = 0;
+
+    bool operator==(const dir_identity&) const noexcept = default;
+};
+
+/// Get the identity of the directory at the given path, or nullopt if it cannot be obtained
+std::optional<dir_identity> get_dir_identity(const std::filesystem::path& dirpath) noexcept;
+
+/// Determine whether the given directory entry name is a dot-file
+inline bool is_dotfile_name(const std::filesystem::path& filename) noexcept {
+    auto& native = filename.native();
+    return !native.empty() && native.front() == '.';
+}
+
+/**
+ * @brief Check the policies of `opts` to determine whether a search that is `depth` directories
+ * beneath the search root should descend into `entry`.
+ *
+ * @note Does not perform cycle detection
+ */
+bool should_descend(const glob_search_options&              opts,
+                    const std::filesystem::directory_entry& entry,
+                    std::size_t                             depth);
+
+}  // namespace glob_detail
+
 /**
  * @brief An object that can be used to scan directories for files that match
  * a certain pattern.
@@ -31,7 +110,12 @@ public:
     public:
         iterator() = default;
         /// Begin searching `dirpath` using glob `glb`
-        iterator(const glob& glb, const std::filesystem::path& dirpath);
+        iterator(const glob& glb, const std::filesystem::path& dirpath)
+            : iterator(glb, dirpath, glob_search_options{}) {}
+        /// Begin searching `dirpath` using glob `glb`, with the given search options
+        iterator(const glob&                  glb,
+                 const std::filesystem::path& dirpath,
+                 const glob_search_options&   opts);
         /// Obtian the current entry
         std::filesystem::directory_entry dereference() const;
         /// Advance to the next matching entry, or finish
@@ -87,6 +171,18 @@ public:
     [[nodiscard]] iterator search(const std::filesystem::path& path) const noexcept {
         return iterator(*this, path);
     }
+
+    /**
+     * @brief Create a new search iterator of the given directory path
+     *
+     * @param path A path to an existing directory from which the search will execute
+     * @param opts Options that control the directory traversal
+     * @return iterator
+     */
+    [[nodiscard]] iterator search(const std::filesystem::path& path,
+                                  const glob_search_options&   opts) const {
+        return iterator(*this, path, opts);
+    }
 };
 
 }  // namespace btr
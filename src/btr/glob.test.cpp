@@ -1,5 +1,7 @@
 #include "./glob.hpp"
 
+#include "./file.hpp"
+
 #include <catch2/catch.hpp>
 
 const auto THIS_DIR = std::filesystem::path(__FILE__).parent_path();
@@ -54,3 +56,63 @@ TEST_CASE("Check globs") {
     glob = btr::glob::compile("doc/**");
     CHECK(glob.test("doc/something.txt"));
 }
+
+TEST_CASE("Search with options") {
+    auto root_dir = std::filesystem::weakly_canonical(THIS_DIR / "../..").lexically_normal();
+    auto data_dir = root_dir / "data";
+
+    auto glob = btr::glob::compile("glob-test-1/**/*.txt");
+    CHECK(glob.search(data_dir).to_vector().size() == 3);
+    CHECK(glob.search(data_dir, {.max_depth = 2}).to_vector().size() == 1);
+    CHECK(glob.search(data_dir, {.max_depth = 1}).to_vector().size() == 0);
+
+    auto found = glob.search(data_dir,
+                             {.prune = [](auto&& entry) {
+                                  return entry.path().filename() == "glob-test-2";
+                              }})
+                     .to_vector();
+    CHECK(found.size() == 1);
+}
+
+TEST_CASE("Search with dot-files and symlink cycles") {
+    namespace fs = std::filesystem;
+    auto tmp     = fs::temp_directory_path() / "btr-glob-test";
+    fs::remove_all(tmp);
+    fs::create_directories(tmp / "sub/.hidden");
+    btr::file::write(tmp / "sub/a.txt", "a");
+    btr::file::write(tmp / "sub/.b.txt", "b");
+    btr::file::write(tmp / "sub/.hidden/c.txt", "c");
+    std::error_code ec;
+    fs::create_directory_symlink(tmp / "sub", tmp / "link", ec);
+    fs::create_directory_symlink(tmp, tmp / "sub/loop", ec);
+
+    auto glob = btr::glob::compile("**/*.txt");
+    // The 'link' is followed, but the 'loop' is never entered
+    auto found = glob.search(tmp).to_vector();
+    CHECK(found.size() == (ec ? 3 : 6));
+
+    found = glob.search(tmp, {.follow_symlinks = false}).to_vector();
+    CHECK(found.size() == 3);
+
+    found = glob.search(tmp, {.follow_symlinks = false, .dotfiles = btr::glob_dotfiles::exclude})
+                .to_vector();
+    CHECK(found.size() == 1);
+
+    found = glob.search(tmp,
+                        {.follow_symlinks = false, .dotfiles = btr::glob_dotfiles::explicit_only})
+                .to_vector();
+    CHECK(found.size() == 1);
+
+    found = btr::glob::compile("**/.*.txt")
+                .search(tmp,
+                        {.follow_symlinks = false, .dotfiles = btr::glob_dotfiles::explicit_only})
+                .to_vector();
+    CHECK(found.size() == 1);
+
+    found = btr::glob::compile("sub/.hidden/*.txt")
+                .search(tmp, {.dotfiles = btr::glob_dotfiles::explicit_only})
+                .to_vector();
+    CHECK(found.size() == 1);
+
+    fs::remove_all(tmp);
+}
@@ -0,0 +1,326 @@
+#include "./glob_set.hpp"
+
+#include "./fnmatch.hpp"
+
+#include <algorithm>
+#include <optional>
+
+using namespace btr;
+namespace fs = std::filesystem;
+
+namespace {
+
+enum class node_kind {
+    /// A regular path element, matched with an fnmatch pattern
+    fnmatch,
+    /// A '**' that is followed by more pattern elements. Matches zero or more path elements.
+    rglob,
+    /// A '**' that is the final element of a pattern. Matches one or more path elements.
+    rglob_tail,
+};
+
+/**
+ * A node in the trie of pattern elements. Patterns that share a leading sequence of elements share
+ * the nodes for those elements.
+ */
+struct trie_node {
+    node_kind                      kind = node_kind::fnmatch;
+    std::string                    spelling;
+    std::optional<fnmatch_pattern> pattern;
+
+    std::vector<std::unique_ptr<trie_node>> children;
+
+    /// The greatest index of an include rule that ends at this node, or -1
+    std::ptrdiff_t max_include_here = -1;
+    /// The greatest index of an exclude rule that ends at this node, or -1
+    std::ptrdiff_t max_exclude_here = -1;
+    /// The greatest index of an include rule that ends at any node strictly below this one, or -1
+    std::ptrdiff_t max_include_below = -1;
+
+    trie_node& child_for(node_kind k, std::string_view spell) {
+        for (auto& c : children) {
+            if (c->kind == k && c->spelling == spell) {
+                return *c;
+            }
+        }
+        auto& ret    = *children.emplace_back(std::make_unique<trie_node>());
+        ret.kind     = k;
+        ret.spelling = std::string(spell);
+        if (k == node_kind::fnmatch) {
+            ret.pattern = fnmatch_pattern::compile(ret.spelling);
+        }
+        return ret;
+    }
+
+    void finalize() noexcept {
+        for (auto& c : children) {
+            c->finalize();
+            max_include_below = (std::max)({max_include_below,
+                                            c->max_include_here,
+                                            c->max_include_below});
+        }
+        if (kind == node_kind::rglob_tail) {
+            // A tail matches every path element beneath itself
+            max_include_below = (std::max)(max_include_below, max_include_here);
+        }
+    }
+};
+
+using state_set = std::vector<const trie_node*>;
+
+void add_state(state_set& set, const trie_node* n) noexcept {
+    if (std::ranges::find(set, n) != set.end()) {
+        return;
+    }
+    set.push_back(n);
+    // Non-final '**' elements may match zero path elements, so their children are also active
+    for (auto& c : n->children) {
+        if (c->kind == node_kind::rglob) {
+            add_state(set, c.get());
+        }
+    }
+}
+
+/// The result of evaluating all rules against a single path element
+struct step_result {
+    /// The trie nodes that are active after the step
+    state_set states;
+    /// The index of the last rule that matched, or -1
+    std::ptrdiff_t last_rule = -1;
+    /// Whether the last rule that matched is an exclude rule
+    bool excluded = false;
+};
+
+}  // namespace
+
+struct glob_set::impl {
+    trie_node root;
+
+    state_set initial_states() const noexcept {
+        state_set ret;
+        add_state(ret, &root);
+        return ret;
+    }
+
+    /**
+     * Evaluate the path element `elem` against each of the given active states. If `explicit_dot`
+     * is true, the element may only be matched by fnmatch patterns that begin with a period.
+     */
+    void step(const state_set&   states,
+              std::u8string_view elem,
+              step_result&       out,
+              bool               explicit_dot = false) const {
+        out.states.clear();
+        out.last_rule = -1;
+        out.excluded  = false;
+        for (const trie_node* node : states) {
+            if (node->kind != node_kind::fnmatch && !explicit_dot) {
+                // Recursive globs consume any path element and remain active
+                add_state(out.states, node);
+            }
+            for (auto& child : node->children) {
+                if (child->kind == node_kind::rglob) {
+                    // Already active, via add_state()
+                    continue;
+                }
+                if (child->kind == node_kind::rglob_tail) {
+                    if (!explicit_dot) {
+                        add_state(out.states, child.get());
+                    }
+                } else if (explicit_dot && !child->spelling.starts_with('.')) {
+                    continue;
+                } else if (child->pattern->test(elem)) {
+                    add_state(out.states, child.get());
+                }
+            }
+        }
+        for (const trie_node* node : out.states) {
+            if (node->max_include_here > out.last_rule) {
+                out.last_rule = node->max_include_here;
+                out.excluded  = false;
+            }
+            if (node->max_exclude_here > out.last_rule) {
+                out.last_rule = node->max_exclude_here;
+                out.excluded  = true;
+            }
+        }
+    }
+
+    /**
+     * Determine whether a directory that produced the given step result may contain any included
+     * paths.
+     */
+    bool may_descend(const step_result& res) const noexcept {
+        if (res.excluded) {
+            // The directory itself is excluded, so nothing beneath it may be included
+            return false;
+        }
+        std::ptrdiff_t max_include = -1;
+        std::ptrdiff_t max_exclude = -1;
+        for (const trie_node* node : res.states) {
+            max_include = (std::max)(max_include, node->max_include_below);
+            for (auto& child : node->children) {
+                if (child->kind == node_kind::rglob_tail) {
+                    max_exclude = (std::max)(max_exclude, child->max_exclude_here);
+                }
+            }
+            if (node->kind == node_kind::rglob_tail) {
+                max_exclude = (std::max)(max_exclude, node->max_exclude_here);
+            }
+        }
+        // If every path beneath is excluded by a rule that no later include rule could override,
+        // then there is no reason to descend.
+        return max_include > max_exclude;
+    }
+};
+
+glob_set glob_set::_compile(std::vector<rule> rules) {
+    auto acc = std::make_shared<impl>();
+
+    for (std::size_t idx = 0; idx < rules.size(); ++idx) {
+        const auto& pattern = rules[idx].pattern;
+
+        std::vector<std::u8string> elems;
+        for (fs::path elem : pattern) {
+            auto str = elem.u8string();
+            // Consecutive rglobs are folded, as in btr::glob
+            if (str == u8"**" && !elems.empty() && elems.back() == u8"**") {
+                continue;
+            }
+            elems.push_back(std::move(str));
+        }
+
+        trie_node* node = &acc->root;
+        for (auto it = elems.cbegin(); it != elems.cend(); ++it) {
+            std::string spell{it->begin(), it->end()};
+            if (*it != u8"**") {
+                node = &node->child_for(node_kind::fnmatch, spell);
+            } else if (std::next(it) == elems.cend()) {
+                node = &node->child_for(node_kind::rglob_tail, spell);
+            } else {
+                node = &node->child_for(node_kind::rglob, spell);
+            }
+        }
+
+        const auto sidx = static_cast<std::ptrdiff_t>(idx);
+        if (rules[idx].is_exclude) {
+            node->max_exclude_here = sidx;
+        } else {
+            node->max_include_here = sidx;
+        }
+    }
+
+    acc->root.finalize();
+    glob_set ret;
+    ret._impl = std::move(acc);
+    return ret;
+}
+
+bool glob_set::test(const fs::path& filepath) const noexcept {
+    auto        states = _impl->initial_states();
+    step_result res;
+    bool        first = true;
+    for (fs::path elem : filepath) {
+        if (!first && !_impl->may_descend(res)) {
+            // The parent directory of this element is excluded
+            return false;
+        }
+        first = false;
+        _impl->step(states, elem.u8string(), res);
+        states = res.states;
+    }
+    return !first && res.last_rule >= 0 && !res.excluded;
+}
+
+struct glob_set::iterator::state {
+    std::shared_ptr<const glob_set::impl> impl;
+    glob_search_options                   opts;
+
+    struct frame {
+        fs::directory_iterator                   dir_iter;
+        state_set                                states;
+        std::optional<glob_detail::dir_identity> identity;
+    };
+
+    std::vector<frame>  stack{};
+    fs::directory_entry entry{};
+    step_result         res{};
+
+    /// Advance to the next included entry. Returns false when the search is finished.
+    bool advance() {
+        while (!stack.empty()) {
+            auto& top = stack.back();
+            if (top.dir_iter == fs::directory_iterator()) {
+                stack.pop_back();
+                continue;
+            }
+            entry = *top.dir_iter++;
+
+            auto       filename = entry.path().filename();
+            const bool is_dot   = glob_detail::is_dotfile_name(filename);
+            if (is_dot && opts.dotfiles == glob_dotfiles::exclude) {
+                continue;
+            }
+            impl->step(top.states,
+                       filename.u8string(),
+                       res,
+                       is_dot && opts.dotfiles == glob_dotfiles::explicit_only);
+            const bool included = res.last_rule >= 0 && !res.excluded;
+            if (!res.states.empty() && impl->may_descend(res)) {
+                try_push(res.states);
+            }
+            if (included) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Push a new frame to search the current entry, if the search options permit it
+    void try_push(const state_set& states) {
+        const auto depth = stack.size() - 1;
+        if (!glob_detail::should_descend(opts, entry, depth)) {
+            return;
+        }
+        std::optional<glob_detail::dir_identity> identity;
+        if (opts.follow_symlinks) {
+            identity = glob_detail::get_dir_identity(entry.path());
+            if (identity) {
+                for (auto& fr : stack) {
+                    if (fr.identity == identity) {
+                        // This directory is already being searched. We've found a symlink cycle.
+                        return;
+                    }
+                }
+            }
+        }
+        stack.push_back(frame{fs::directory_iterator{entry.path()}, states, identity});
+    }
+};
+
+glob_set::iterator::iterator(const glob_set&            set,
+                             const fs::path&            dirpath,
+                             const glob_search_options& opts)
+    : _state(std::make_shared<state>())
+    , _done(false) {
+    _state->impl = set._impl;
+    _state->opts = opts;
+    _state->stack.push_back(state::frame{
+        fs::directory_iterator{dirpath},
+        _state->impl->initial_states(),
+        opts.follow_symlinks ? glob_detail::get_dir_identity(dirpath) : std::nullopt,
+    });
+    increment();
+}
+
+fs::directory_entry glob_set::iterator::dereference() const { return _state->entry; }
+void                glob_set::iterator::increment() { _done = !_state->advance(); }
+
+std::vector<fs::directory_entry> glob_set::iterator::to_vector() {
+    std::vector<fs::directory_entry> ret;
+    while (!at_end()) {
+        ret.push_back(dereference());
+        increment();
+    }
+    return ret;
+}
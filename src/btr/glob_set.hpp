@@ -0,0 +1,137 @@
+#pragma once
+
+#include "./glob.hpp"
+
+#include <neo/iterator_facade.hpp>
+
+#include <filesystem>
+#include <initializer_list>
+#include <memory>
+#include <ranges>
+#include <vector>
+
+namespace btr {
+
+/**
+ * @brief A compiled set of include and exclude glob patterns that can be evaluated together.
+ *
+ * Rules are evaluated in order, and the last rule that matches a path decides whether the path is
+ * included or excluded. A path that matches no rule is not included. As with `.gitignore`, once a
+ * directory is excluded, nothing within that directory can be re-included by a later rule.
+ *
+ * All patterns are compiled into a single trie of path elements, so a search of a directory
+ * evaluates every rule in a single traversal and does not descend into directories that cannot
+ * contain any included path.
+ */
+class glob_set {
+    struct impl;
+    std::shared_ptr<const impl> _impl;
+
+public:
+    /**
+     * @brief A single include or exclude rule for a glob_set
+     */
+    struct rule {
+        /// Whether paths matching this rule are excluded (rather than included)
+        bool is_exclude = false;
+        /// The glob pattern of the rule. Uses the same syntax as btr::glob::compile()
+        std::filesystem::path pattern;
+    };
+
+    /// Create a rule that includes paths matching the given glob pattern
+    [[nodiscard]] static rule include(std::filesystem::path pattern) {
+        return rule{false, std::move(pattern)};
+    }
+
+    /// Create a rule that excludes paths matching the given glob pattern
+    [[nodiscard]] static rule exclude(std::filesystem::path pattern) {
+        return rule{true, std::move(pattern)};
+    }
+
+private:
+    static glob_set _compile(std::vector<rule> rules);
+
+public:
+
+    /**
+     * @brief A search iterator (also a range with begin() and end()) that yields each included
+     * entry within a directory.
+     */
+    class iterator : public neo::iterator_facade<iterator> {
+        struct state;
+        std::shared_ptr<state> _state;
+
+        bool _done = true;
+
+    public:
+        iterator() = default;
+        /// Begin searching `dirpath` using the rules of `set`, with the given search options
+        iterator(const glob_set&              set,
+                 const std::filesystem::path& dirpath,
+                 const glob_search_options&   opts = {});
+        /// Obtain the current entry
+        std::filesystem::directory_entry dereference() const;
+        /// Advance to the next included entry, or finish
+        void increment();
+
+        // A sentinel to signal the end-of-range
+        struct sentinel_type {};
+
+        bool operator==(sentinel_type) const noexcept { return at_end(); }
+        /// Check whether we are finished with a search
+        bool at_end() const noexcept { return _done; }
+
+        /// Returns *this (for use with range-for and range-algorithms)
+        iterator begin() const noexcept { return *this; }
+        /// Return a sentinel (for use with range-for and range-algorithms)
+        sentinel_type end() const noexcept { return {}; }
+
+        /**
+         * @brief Exhaust the iterator and collect all search results into a vector.
+         *
+         * @note This should be called immediately after constructing the iterator, or to_vector()
+         * will return unspecified results
+         */
+        [[nodiscard]] std::vector<std::filesystem::directory_entry> to_vector();
+    };
+
+    /**
+     * @brief Compile a new glob_set from the given sequence of rules.
+     *
+     * @param rules The rules of the set. Later rules take precedence over earlier rules.
+     *
+     * @throws bad_fnmatch_pattern if any pattern element is not a valid fnmatch() pattern
+     */
+    [[nodiscard]] static glob_set compile(std::initializer_list<rule> rules) {
+        return _compile(std::vector<rule>(rules));
+    }
+
+    /// @copydoc compile(std::initializer_list<rule>)
+    template <std::ranges::input_range R>
+    requires std::convertible_to<std::ranges::range_reference_t<R>, const rule&>  //
+        [[nodiscard]] static glob_set compile(R&& rules) {
+        std::vector<rule> vec;
+        for (const rule& r : rules) {
+            vec.push_back(r);
+        }
+        return _compile(std::move(vec));
+    }
+
+    /**
+     * @brief Test whether the given relative path is included by the set
+     */
+    [[nodiscard]] bool test(const std::filesystem::path& path) const noexcept;
+
+    /**
+     * @brief Create a new search iterator of the given directory path
+     *
+     * @param path A path to an existing directory from which the search will execute
+     * @param opts Options that control the directory traversal
+     */
+    [[nodiscard]] iterator search(const std::filesystem::path& path,
+                                  const glob_search_options&   opts = {}) const {
+        return iterator(*this, path, opts);
+    }
+};
+
+}  // namespace btr
@@ -0,0 +1,90 @@
+#include "./glob_set.hpp"
+
+#include <catch2/catch.hpp>
+
+const auto THIS_DIR = std::filesystem::path(__FILE__).parent_path();
+
+TEST_CASE("Check glob sets") {
+    auto set = btr::glob_set::compile({
+        btr::glob_set::include("src/**/*.cpp"),
+        btr::glob_set::include("include/**/*.hpp"),
+        btr::glob_set::exclude("src/**/*.test.cpp"),
+        btr::glob_set::include("src/keep.test.cpp"),
+    });
+    CHECK(set.test("src/foo.cpp"));
+    CHECK(set.test("src/thing/foo.cpp"));
+    CHECK(set.test("include/foo.hpp"));
+    CHECK(set.test("src/keep.test.cpp"));
+    CHECK_FALSE(set.test("src/foo.hpp"));
+    CHECK_FALSE(set.test("include/foo.cpp"));
+    CHECK_FALSE(set.test("src/foo.test.cpp"));
+    CHECK_FALSE(set.test("src/thing/foo.test.cpp"));
+    CHECK_FALSE(set.test("src"));
+
+    // Nothing within an excluded directory can be re-included
+    set = btr::glob_set::compile({
+        btr::glob_set::include("**/*.txt"),
+        btr::glob_set::exclude("build"),
+        btr::glob_set::include("build/keep.txt"),
+    });
+    CHECK(set.test("foo.txt"));
+    CHECK(set.test("foo/bar.txt"));
+    CHECK_FALSE(set.test("build"));
+    CHECK_FALSE(set.test("build/foo.txt"));
+    CHECK_FALSE(set.test("build/keep.txt"));
+
+    set = btr::glob_set::compile({
+        btr::glob_set::include("doc/**"),
+        btr::glob_set::exclude("doc/**/*.tmp"),
+    });
+    CHECK(set.test("doc/something.txt"));
+    CHECK(set.test("doc/sub/something.txt"));
+    CHECK_FALSE(set.test("doc"));
+    CHECK_FALSE(set.test("doc/something.tmp"));
+}
+
+TEST_CASE("Search with a glob set") {
+    auto root_dir = std::filesystem::weakly_canonical(THIS_DIR / "../..").lexically_normal();
+    auto data_dir = root_dir / "data";
+
+    auto found = btr::glob_set::compile({
+                                            btr::glob_set::include("**/*.txt"),
+                                        })
+                     .search(data_dir)
+                     .to_vector();
+    CHECK(found.size() == 3);
+
+    found = btr::glob_set::compile({
+                                       btr::glob_set::include("**/*.txt"),
+                                       btr::glob_set::exclude("glob-test-1/foo/foo"),
+                                   })
+                .search(data_dir)
+                .to_vector();
+    REQUIRE(found.size() == 1);
+    CHECK(found[0].path().filename() == "upper.txt");
+
+    found = btr::glob_set::compile({
+                                       btr::glob_set::include("glob-test-1/**/file.txt"),
+                                       btr::glob_set::include("glob-test-1/**/bar"),
+                                       btr::glob_set::include("**/upper.txt"),
+                                       btr::glob_set::exclude("**/upper.txt"),
+                                   })
+                .search(data_dir)
+                .to_vector();
+    CHECK(found.size() == 2);
+}
+
+TEST_CASE("Search with a glob set and options") {
+    auto root_dir = std::filesystem::weakly_canonical(THIS_DIR / "../..").lexically_normal();
+    auto data_dir = root_dir / "data";
+
+    auto set = btr::glob_set::compile({btr::glob_set::include("**/*.txt")});
+    CHECK(set.search(data_dir, {.max_depth = 1}).to_vector().size() == 0);
+    CHECK(set.search(data_dir, {.max_depth = 2}).to_vector().size() == 1);
+    auto found = set.search(data_dir,
+                            {.prune = [](auto&& entry) {
+                                 return entry.path().filename() == "bar";
+                             }})
+                     .to_vector();
+    CHECK(found.size() == 1);
+}
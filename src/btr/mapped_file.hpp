@@ -0,0 +1,83 @@
+#pragma once
+
+#include "./trivial_range.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <string_view>
+
+namespace btr {
+
+/**
+ * @brief A read-only memory mapping of the entire content of a file.
+ *
+ * The content is read from the page cache on demand, without copying it into a buffer. The mapping
+ * remains valid even if the file is subsequently renamed or removed.
+ */
+class mapped_file {
+    const std::byte* _data = nullptr;
+    std::size_t      _size = 0;
+
+    mapped_file(const std::byte* data, std::size_t size) noexcept
+        : _data(data)
+        , _size(size) {}
+
+    /// Unmap the memory
+    void _unmap() noexcept;
+
+public:
+    /// Default-construct an empty mapping
+    mapped_file() = default;
+
+    mapped_file(mapped_file&& o) noexcept
+        : _data(o._data)
+        , _size(o._size) {
+        o._data = nullptr;
+        o._size = 0;
+    }
+
+    mapped_file& operator=(mapped_file&& o) noexcept {
+        close();
+        _data   = o._data;
+        _size   = o._size;
+        o._data = nullptr;
+        o._size = 0;
+        return *this;
+    }
+
+    ~mapped_file() { close(); }
+
+    /**
+     * @brief Map the file at the given path into memory
+     *
+     * @throws file_not_found_error if the file does not exist
+     * @throws file_error if we are unable to open or map the file
+     */
+    [[nodiscard]] static mapped_file open(const std::filesystem::path& filepath);
+
+    /// Unmap the file. If the file is not mapped, does nothing.
+    void close() noexcept {
+        if (_data) {
+            _unmap();
+        }
+        _data = nullptr;
+        _size = 0;
+    }
+
+    /// Get the number of bytes in the mapping
+    [[nodiscard]] std::size_t size() const noexcept { return _size; }
+    /// Determine whether the mapping is empty
+    [[nodiscard]] bool empty() const noexcept { return _size == 0; }
+
+    /// Get the mapped bytes
+    [[nodiscard]] std::span<const std::byte> bytes() const noexcept { return {_data, _size}; }
+    /// Get the mapped content as a string of characters
+    [[nodiscard]] std::string_view string_view() const noexcept {
+        return {reinterpret_cast<const char*>(_data), _size};
+    }
+    /// Get the mapped content as a buffer
+    [[nodiscard]] const_buffer buffer() const noexcept { return const_buffer(_data, _size); }
+};
+
+}  // namespace btr
@@ -0,0 +1,58 @@
+#include "./mapped_file.hpp"
+
+#include "./file.hpp"
+
+#include <neo/ufmt.hpp>
+
+#if !_WIN32
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace btr;
+
+namespace {
+
+[[noreturn]] void throw_map_error(int err, const std::filesystem::path& fpath, const char* what) {
+    auto ec = std::error_code{err, std::system_category()};
+    if (err == ENOENT) {
+        throw file_not_found_error(ec,
+                                   neo::ufmt("Cannot map non-existent file [{}]", fpath.string()));
+    }
+    throw file_error(ec, neo::ufmt("Failed to map file [{}]: {}", fpath.string(), what));
+}
+
+}  // namespace
+
+mapped_file mapped_file::open(const std::filesystem::path& fpath) {
+    const int fd = ::open(fpath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw_map_error(errno, fpath, "::open() failed");
+    }
+    struct ::stat st;
+    if (::fstat(fd, &st) != 0) {
+        const int err = errno;
+        ::close(fd);
+        throw_map_error(err, fpath, "::fstat() failed");
+    }
+    const auto size = static_cast<std::size_t>(st.st_size);
+    if (size == 0) {
+        // Empty files cannot be mapped
+        ::close(fd);
+        return mapped_file{};
+    }
+    void*     ptr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    const int err = errno;
+    // The mapping holds its own reference to the file
+    ::close(fd);
+    if (ptr == MAP_FAILED) {
+        throw_map_error(err, fpath, "::mmap() failed");
+    }
+    return mapped_file{static_cast<const std::byte*>(ptr), size};
+}
+
+void mapped_file::_unmap() noexcept { ::munmap(const_cast<std::byte*>(_data), _size); }
+
+#endif
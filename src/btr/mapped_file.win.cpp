@@ -0,0 +1,67 @@
+#include "./mapped_file.hpp"
+
+#include "./file.hpp"
+
+#include <neo/ufmt.hpp>
+
+#if _WIN32
+
+#include <windows.h>
+
+using namespace btr;
+
+namespace {
+
+[[noreturn]] void throw_map_error(DWORD err, const std::filesystem::path& fpath, const char* what) {
+    auto ec = std::error_code{static_cast<int>(err), std::system_category()};
+    if (err == ERROR_FILE_NOT_FOUND || err == ERROR_PATH_NOT_FOUND) {
+        throw file_not_found_error(ec,
+                                   neo::ufmt("Cannot map non-existent file [{}]", fpath.string()));
+    }
+    throw file_error(ec, neo::ufmt("Failed to map file [{}]: {}", fpath.string(), what));
+}
+
+}  // namespace
+
+mapped_file mapped_file::open(const std::filesystem::path& fpath) {
+    // Allow other processes to rename and delete the file while it is mapped
+    HANDLE file = ::CreateFileW(fpath.c_str(),
+                                GENERIC_READ,
+                                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                nullptr,
+                                OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL,
+                                nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw_map_error(::GetLastError(), fpath, "::CreateFileW() failed");
+    }
+    LARGE_INTEGER size;
+    if (!::GetFileSizeEx(file, &size)) {
+        const auto err = ::GetLastError();
+        ::CloseHandle(file);
+        throw_map_error(err, fpath, "::GetFileSizeEx() failed");
+    }
+    if (size.QuadPart == 0) {
+        // Empty files cannot be mapped
+        ::CloseHandle(file);
+        return mapped_file{};
+    }
+    HANDLE     mapping = ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const auto err     = ::GetLastError();
+    ::CloseHandle(file);
+    if (!mapping) {
+        throw_map_error(err, fpath, "::CreateFileMappingW() failed");
+    }
+    // The view holds its own reference to the mapping
+    void*      ptr      = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    const auto view_err = ::GetLastError();
+    ::CloseHandle(mapping);
+    if (!ptr) {
+        throw_map_error(view_err, fpath, "::MapViewOfFile() failed");
+    }
+    return mapped_file{static_cast<const std::byte*>(ptr), static_cast<std::size_t>(size.QuadPart)};
+}
+
+void mapped_file::_unmap() noexcept { ::UnmapViewOfFile(_data); }
+
+#endif
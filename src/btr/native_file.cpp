@@ -0,0 +1,40 @@
+#include "./native_file.hpp"
+
+#include <span>
+
+using namespace btr;
+
+namespace {
+
+/// The initial buffer size when reading a stream of unknown size
+constexpr std::size_t stream_chunk_size = 64 * 1024;
+
+}  // namespace
+
+std::string native_file::read_all() {
+    std::string ret;
+    if (_is_regular()) {
+        // Ask for one more byte than expected, to detect a file that has grown since we got its
+        // size
+        ret.resize(size() + 1);
+        auto nread = read_at(ret, 0);
+        while (nread == ret.size()) {
+            ret.resize(ret.size() * 2);
+            nread += read_at(std::span<char>(ret).subspan(nread), nread);
+        }
+        ret.resize(nread);
+        return ret;
+    }
+
+    // Pipes and devices cannot be read at an offset, so read until the end of the stream
+    ret.resize(stream_chunk_size);
+    std::size_t nread = 0;
+    while (auto n = _read_next(mutable_buffer(std::span<char>(ret).subspan(nread)))) {
+        nread += n;
+        if (nread == ret.size()) {
+            ret.resize(ret.size() * 2);
+        }
+    }
+    ret.resize(nread);
+    return ret;
+}
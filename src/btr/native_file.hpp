@@ -0,0 +1,158 @@
+#pragma once
+
+#include "./native_io.hpp"
+#include "./trivial_range.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace btr {
+
+/**
+ * @brief Options for opening a native_file
+ */
+struct native_file_options {
+    /// Open the file for reading
+    bool read = true;
+    /// Open the file for writing
+    bool write = false;
+    /// Create the file if it does not exist. Requires `write`.
+    bool create = false;
+    /// Truncate the file to zero length when it is opened. Requires `write`.
+    bool truncate = false;
+    /// Fail if the file already exists. Requires `create`.
+    bool exclusive = false;
+    /// Perform every sequential write at the end of the file
+    bool append = false;
+    /**
+     * @brief Bypass the OS page cache (`O_DIRECT`/`FILE_FLAG_NO_BUFFERING`).
+     *
+     * @note Buffers, offsets, and sizes of I/O on such a file must be aligned as required by the
+     * OS and filesystem, or the I/O will fail.
+     */
+    bool direct = false;
+    /**
+     * @brief Do not update the file's access time when it is read (`O_NOATIME`).
+     *
+     * Ignored if the OS does not support it, or if the caller is not permitted to use it.
+     */
+    bool no_access_time = false;
+    /// Allow the file handle to be inherited by child processes
+    bool inheritable = false;
+};
+
+/**
+ * @brief A file that is read and written directly with the OS's file APIs.
+ *
+ * Unlike btr::file, there is no intermediate buffering: Data is copied directly between the
+ * caller's buffer and the OS. In addition to the sequential I/O of native_io_stream, a native_file
+ * supports positional I/O with read_at() and write_at(). Positional I/O does not use or modify the
+ * file's position, so it may be performed on a single native_file by multiple threads
+ * simultaneously.
+ */
+class native_file : public native_io_stream {
+    /**
+     * On Windows, a second handle to the file that is opened for overlapped I/O. Positional I/O
+     * on a synchronous handle moves its file pointer, so positional I/O uses this handle instead.
+     * Unused on other platforms.
+     */
+    native_io_stream _positional;
+
+    native_file(handle_type&& h, handle_type&& positional) noexcept
+        : native_io_stream(NEO_MOVE(h))
+        , _positional(NEO_MOVE(positional)) {}
+
+    std::size_t _read_at(mutable_buffer buf, std::uint64_t offset) const;
+    std::size_t _write_at(const_buffer buf, std::uint64_t offset);
+
+    /// Determine whether this is a regular file, which supports positional I/O and has a size
+    bool _is_regular() const;
+    /// Read the next data at the file position. Returns zero at the end of the stream.
+    std::size_t _read_next(mutable_buffer buf);
+
+public:
+    /// Default-construct a closed file
+    native_file() = default;
+
+    /**
+     * @brief Open the file at the given path
+     *
+     * @throws file_not_found_error if the file does not exist and `opts.create` is not set
+     * @throws file_error if we are unable to open the file
+     */
+    [[nodiscard]] static native_file open(const std::filesystem::path& filepath,
+                                          native_file_options          opts = {});
+
+    /// Close the file
+    void close() noexcept {
+        _positional.close();
+        native_io_stream::close();
+    }
+
+    /**
+     * @brief Read data at the given byte offset in the file.
+     *
+     * @param out A contiguous range of trivially-copyable objects where the data will be stored
+     * @param offset The byte offset in the file at which to begin reading
+     * @return std::size_t The number of *objects* that were read. This is less than 'size(out)'
+     *      only if the end of the file was reached.
+     *
+     * @throws file_error if the read fails, or if the file does not support positional I/O (e.g. a
+     *      pipe)
+     */
+    std::size_t read_at(mutable_trivial_range auto&& out, std::uint64_t offset) const {
+        return _read_at(mutable_buffer(out), offset) / neo::data_type_size_v<decltype(out)>;
+    }
+
+    /**
+     * @brief Write data at the given byte offset in the file. The file is extended if necessary.
+     *
+     * @param data The data to be written
+     * @param offset The byte offset in the file at which to begin writing
+     * @return std::size_t The number of *objects* that were written. All of `data` is written
+     *      unless an error occurs.
+     *
+     * @throws file_error if the write fails, or if the file does not support positional I/O (e.g. a
+     *      pipe)
+     */
+    std::size_t write_at(trivial_range auto&& data, std::uint64_t offset) {
+        return _write_at(const_buffer(data), offset) / neo::data_type_size_v<decltype(data)>;
+    }
+
+    /**
+     * @brief Read the entire content of the file.
+     *
+     * A regular file is read from its beginning with positional I/O, and the file position is not
+     * used. Other files, such as pipes, FIFOs, and character devices, have no offsets or size: They
+     * are read sequentially from the file position until the end of the stream.
+     *
+     * @throws file_error if the read fails
+     */
+    [[nodiscard]] std::string read_all();
+
+    /**
+     * @brief Get the size of the file, in bytes
+     *
+     * @throws file_error if the size cannot be obtained
+     */
+    [[nodiscard]] std::uint64_t size() const;
+
+    /**
+     * @brief Set the size of the file, in bytes. If the file is extended, the new bytes are zero.
+     *
+     * @throws file_error if the size cannot be changed
+     */
+    void truncate(std::uint64_t size);
+
+    /**
+     * @brief Reserve storage for the given byte range of the file, extending the file if
+     * necessary, so that subsequent writes to the range will not fail for lack of space and the
+     * file is less likely to be fragmented.
+     *
+     * @throws file_error if the storage cannot be allocated
+     */
+    void allocate(std::uint64_t offset, std::uint64_t length);
+};
+
+}  // namespace btr
@@ -0,0 +1,174 @@
+#include "./native_file.hpp"
+
+#include "./file.hpp"
+
+#include <neo/ufmt.hpp>
+
+#if !_WIN32
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace btr;
+
+namespace {
+
+[[noreturn]] void throw_file_error(int err, const char* what) {
+    throw file_error(std::error_code{err, std::system_category()}, what);
+}
+
+}  // namespace
+
+native_file native_file::open(const std::filesystem::path& fpath, native_file_options opts) {
+    int flags = 0;
+    if (opts.read && opts.write) {
+        flags |= O_RDWR;
+    } else if (opts.write) {
+        flags |= O_WRONLY;
+    } else {
+        flags |= O_RDONLY;
+    }
+    flags |= opts.create ? O_CREAT : 0;
+    flags |= opts.truncate ? O_TRUNC : 0;
+    flags |= opts.exclusive ? O_EXCL : 0;
+    flags |= opts.append ? O_APPEND : 0;
+    flags |= opts.inheritable ? 0 : O_CLOEXEC;
+#ifdef O_DIRECT
+    flags |= opts.direct ? O_DIRECT : 0;
+#endif
+#ifdef O_NOATIME
+    flags |= opts.no_access_time ? O_NOATIME : 0;
+#endif
+
+    int fd = ::open(fpath.c_str(), flags, 0666);
+#ifdef O_NOATIME
+    if (fd < 0 && errno == EPERM && (flags & O_NOATIME)) {
+        // Only the owner of a file may open it with O_NOATIME
+        fd = ::open(fpath.c_str(), flags & ~O_NOATIME, 0666);
+    }
+#endif
+    if (fd < 0) {
+        auto ec = std::error_code{errno, std::system_category()};
+        if (errno == ENOENT) {
+            throw file_not_found_error(ec,
+                                       neo::ufmt("Cannot open non-existent file [{}]",
+                                                 fpath.string()));
+        }
+        throw file_error(ec, neo::ufmt("Failed to open file [{}]", fpath.string()));
+    }
+#if __APPLE__
+    if (opts.direct) {
+        // macOS has no O_DIRECT, but can disable caching on an open file
+        ::fcntl(fd, F_NOCACHE, 1);
+    }
+#endif
+    return native_file{NEO_MOVE(fd), handle_type{null_handle}};
+}
+
+std::size_t native_file::_read_at(mutable_buffer buf, std::uint64_t offset) const {
+    neo_assert(expects, is_open(), "Attempted to read from a closed file", offset, buf.size());
+    std::size_t total = 0;
+    while (buf.size()) {
+        auto nread = ::pread(get(), buf.data(), buf.size(), static_cast<::off_t>(offset + total));
+        if (nread < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw_file_error(errno, "::pread() on file failed");
+        }
+        if (nread == 0) {
+            // End of file
+            break;
+        }
+        total += static_cast<std::size_t>(nread);
+        buf = buf + static_cast<std::size_t>(nread);
+    }
+    return total;
+}
+
+std::size_t native_file::_write_at(const_buffer buf, std::uint64_t offset) {
+    neo_assert(expects, is_open(), "Attempted to write to a closed file", offset, buf.size());
+    std::size_t total = 0;
+    while (buf.size()) {
+        auto nwritten
+            = ::pwrite(get(), buf.data(), buf.size(), static_cast<::off_t>(offset + total));
+        if (nwritten < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw_file_error(errno, "::pwrite() on file failed");
+        }
+        total += static_cast<std::size_t>(nwritten);
+        buf = buf + static_cast<std::size_t>(nwritten);
+    }
+    return total;
+}
+
+bool native_file::_is_regular() const {
+    struct ::stat st;
+    if (::fstat(get(), &st) != 0) {
+        throw_file_error(errno, "::fstat() on file failed");
+    }
+    return S_ISREG(st.st_mode);
+}
+
+std::size_t native_file::_read_next(mutable_buffer buf) {
+    neo_assert(expects, is_open(), "Attempted to read from a closed file", buf.size());
+    while (true) {
+        auto nread = ::read(get(), buf.data(), buf.size());
+        if (nread >= 0) {
+            return static_cast<std::size_t>(nread);
+        }
+        if (errno != EINTR) {
+            throw_file_error(errno, "::read() on file failed");
+        }
+    }
+}
+
+std::uint64_t native_file::size() const {
+    struct ::stat st;
+    if (::fstat(get(), &st) != 0) {
+        throw_file_error(errno, "::fstat() on file failed");
+    }
+    return static_cast<std::uint64_t>(st.st_size);
+}
+
+void native_file::truncate(std::uint64_t size) {
+    if (::ftruncate(get(), static_cast<::off_t>(size)) != 0) {
+        throw_file_error(errno, "::ftruncate() on file failed");
+    }
+}
+
+void native_file::allocate(std::uint64_t offset, std::uint64_t length) {
+#if __linux__
+    if (::fallocate(get(), 0, static_cast<::off_t>(offset), static_cast<::off_t>(length)) == 0) {
+        return;
+    }
+    if (errno != EOPNOTSUPP) {
+        throw_file_error(errno, "::fallocate() on file failed");
+    }
+    // The filesystem cannot allocate storage ahead of time, but we can still extend the file
+#elif __APPLE__
+    ::fstore_t store = {};
+    store.fst_flags   = F_ALLOCATEALL;
+    store.fst_posmode = F_PEOFPOSMODE;
+    store.fst_length  = static_cast<::off_t>(length);
+    // Allocation is only a hint on macOS, so failure is not an error
+    (void)::fcntl(get(), F_PREALLOCATE, &store);
+#else
+    if (int err = ::posix_fallocate(get(),
+                                    static_cast<::off_t>(offset),
+                                    static_cast<::off_t>(length));
+        err == 0) {
+        return;
+    } else if (err != EINVAL && err != EOPNOTSUPP) {
+        throw_file_error(err, "::posix_fallocate() on file failed");
+    }
+#endif
+    if (size() < offset + length) {
+        truncate(offset + length);
+    }
+}
+
+#endif
@@ -0,0 +1,101 @@
+#include "./native_file.hpp"
+
+#include "./file.hpp"
+
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+auto THIS_DIR = fs::weakly_canonical(fs::path(__FILE__).parent_path());
+
+TEST_CASE("Open a non-existent native file") {
+    CHECK_THROWS_AS(btr::native_file::open(THIS_DIR / "file-does-not-exist.txt"),
+                    btr::file_not_found_error);
+}
+
+TEST_CASE("Positional reads and writes") {
+    auto fpath = THIS_DIR / "test-native-file.data";
+    auto f     = btr::native_file::open(fpath,
+                                    {.write = true, .create = true, .truncate = true});
+    CHECK(f.size() == 0);
+
+    CHECK(f.write_at(std::string_view("world"), 6) == 5);
+    CHECK(f.write_at(std::string_view("hello "), 0) == 6);
+    CHECK(f.size() == 11);
+
+    std::string buf(5, '\0');
+    CHECK(f.read_at(buf, 6) == 5);
+    CHECK(buf == "world");
+    // Positional I/O does not move the file position
+    buf.resize(11);
+    CHECK(f.read_into(buf) == 11);
+    CHECK(buf == "hello world");
+
+    // Reads stop at the end of the file
+    CHECK(f.read_at(buf, 8) == 3);
+
+    f.truncate(5);
+    CHECK(f.size() == 5);
+    f.allocate(0, 4096);
+    CHECK(f.size() == 4096);
+    f.close();
+    CHECK(btr::file::read(fpath).substr(0, 6) == std::string("hello\0", 6));
+    fs::remove(fpath);
+}
+
+TEST_CASE("Concurrent positional reads") {
+    auto fpath = THIS_DIR / "test-native-file-concurrent.data";
+    {
+        std::vector<std::uint32_t> nums;
+        for (auto i = 0u; i < 4096; ++i) {
+            nums.push_back(i);
+        }
+        auto f = btr::native_file::open(fpath, {.write = true, .create = true, .truncate = true});
+        f.write_at(nums, 0);
+    }
+
+    auto                     f = btr::native_file::open(fpath, {.no_access_time = true});
+    std::vector<std::thread> threads;
+    std::atomic<int>         mismatches{0};
+    for (auto t = 0u; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            std::uint32_t n = 0;
+            for (auto i = t; i < 4096; i += 4) {
+                f.read_at(std::span(&n, 1), i * sizeof n);
+                if (n != i) {
+                    ++mismatches;
+                }
+            }
+        });
+    }
+    for (auto& thr : threads) {
+        thr.join();
+    }
+    CHECK(mismatches == 0);
+    f.close();
+    fs::remove(fpath);
+}
+
+#if !_WIN32
+#include <sys/stat.h>
+
+TEST_CASE("Read all of a FIFO") {
+    auto fpath = THIS_DIR / "test-native-file.fifo";
+    fs::remove(fpath);
+    REQUIRE(::mkfifo(fpath.c_str(), 0600) == 0);
+
+    // Larger than a single read, and than the pipe's buffer
+    const std::string content(300 * 1024, 'f');
+    std::thread       writer{[&] { btr::file::write(fpath, content); }};
+    // A FIFO has no offsets, so this must fall back to sequential reads
+    auto got = btr::file::read(fpath);
+    writer.join();
+    CHECK(got.size() == content.size());
+    CHECK(got == content);
+    fs::remove(fpath);
+}
+#endif
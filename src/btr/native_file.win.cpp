@@ -0,0 +1,225 @@
+#include "./native_file.hpp"
+
+#include "./file.hpp"
+
+#include <neo/ufmt.hpp>
+
+#if _WIN32
+
+#include <windows.h>
+
+#include <algorithm>
+
+using namespace btr;
+
+namespace {
+
+[[noreturn]] void throw_file_error(DWORD err, const char* what) {
+    throw file_error(std::error_code{static_cast<int>(err), std::system_category()}, what);
+}
+
+OVERLAPPED overlapped_at(std::uint64_t offset) noexcept {
+    OVERLAPPED ov = {};
+    ov.Offset     = static_cast<DWORD>(offset);
+    ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    return ov;
+}
+
+/// The largest I/O that can be requested with a single call
+constexpr std::size_t max_io_size = 1024 * 1024 * 1024;
+
+/// An event that is signalled when an overlapped I/O completes
+struct io_event {
+    HANDLE h = ::CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    ~io_event() {
+        if (h) {
+            ::CloseHandle(h);
+        }
+    }
+};
+
+/**
+ * Perform an overlapped read or write at the given offset on a handle that was opened with
+ * FILE_FLAG_OVERLAPPED, and wait for it to complete. Returns the error code of the I/O, or
+ * ERROR_SUCCESS.
+ */
+template <typename Func>
+DWORD overlapped_io(HANDLE h, std::uint64_t offset, Func&& start_io, DWORD& ntransferred) {
+    io_event ev;
+    if (!ev.h) {
+        return ::GetLastError();
+    }
+    auto ov   = overlapped_at(offset);
+    ov.hEvent = ev.h;
+    if (!start_io(&ov) && ::GetLastError() != ERROR_IO_PENDING) {
+        return ::GetLastError();
+    }
+    if (!::GetOverlappedResult(h, &ov, &ntransferred, TRUE)) {
+        return ::GetLastError();
+    }
+    return ERROR_SUCCESS;
+}
+
+}  // namespace
+
+native_file native_file::open(const std::filesystem::path& fpath, native_file_options opts) {
+    DWORD access = 0;
+    access |= opts.read ? GENERIC_READ : 0;
+    access |= opts.write ? GENERIC_WRITE : 0;
+    if (opts.append) {
+        // Appending handles write only at the end of the file
+        access = (access & ~GENERIC_WRITE) | FILE_APPEND_DATA;
+    }
+
+    DWORD disposition = OPEN_EXISTING;
+    if (opts.create && opts.exclusive) {
+        disposition = CREATE_NEW;
+    } else if (opts.create && opts.truncate) {
+        disposition = CREATE_ALWAYS;
+    } else if (opts.create) {
+        disposition = OPEN_ALWAYS;
+    } else if (opts.truncate) {
+        disposition = TRUNCATE_EXISTING;
+    }
+
+    DWORD flags = FILE_ATTRIBUTE_NORMAL;
+    flags |= opts.direct ? (FILE_FLAG_NO_BUFFERING | FILE_FLAG_WRITE_THROUGH) : 0;
+
+    SECURITY_ATTRIBUTES sa = {};
+    sa.nLength             = sizeof sa;
+    sa.bInheritHandle      = opts.inheritable ? TRUE : FALSE;
+
+    HANDLE h = ::CreateFileW(fpath.c_str(),
+                             access,
+                             FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                             &sa,
+                             disposition,
+                             flags,
+                             nullptr);
+    if (h == INVALID_HANDLE_VALUE) {
+        const auto err = ::GetLastError();
+        auto       ec  = std::error_code{static_cast<int>(err), std::system_category()};
+        if (err == ERROR_FILE_NOT_FOUND || err == ERROR_PATH_NOT_FOUND) {
+            throw file_not_found_error(ec,
+                                       neo::ufmt("Cannot open non-existent file [{}]",
+                                                 fpath.string()));
+        }
+        throw file_error(ec, neo::ufmt("Failed to open file [{}]", fpath.string()));
+    }
+    native_io_stream primary{NEO_MOVE(h)};
+    if (opts.no_access_time) {
+        // A last-access time of 0xFFFFFFFF'FFFFFFFF suspends access-time updates for this handle
+        FILETIME keep = {0xFFFFFFFF, 0xFFFFFFFF};
+        ::SetFileTime(primary.get(), nullptr, &keep, nullptr);
+    }
+
+    // Pipes and devices have no offsets, so only regular files get a handle for positional I/O
+    HANDLE positional = INVALID_HANDLE_VALUE;
+    if (::GetFileType(primary.get()) == FILE_TYPE_DISK) {
+        positional = ::ReOpenFile(primary.get(),
+                                  access,
+                                  FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                  (flags & ~FILE_ATTRIBUTE_NORMAL) | FILE_FLAG_OVERLAPPED);
+        if (positional == INVALID_HANDLE_VALUE) {
+            throw_file_error(::GetLastError(), "::ReOpenFile() on file failed");
+        }
+    }
+    auto primary_h = primary.release();
+    return native_file{NEO_MOVE(primary_h), NEO_MOVE(positional)};
+}
+
+std::size_t native_file::_read_at(mutable_buffer buf, std::uint64_t offset) const {
+    neo_assert(expects, is_open(), "Attempted to read from a closed file", offset, buf.size());
+    if (!_positional.is_open()) {
+        throw_file_error(ERROR_INVALID_FUNCTION, "Positional reads require a regular file");
+    }
+    std::size_t total = 0;
+    while (buf.size()) {
+        DWORD nread = 0;
+        auto  want  = static_cast<DWORD>((std::min)(buf.size(), max_io_size));
+        auto  start = [&](OVERLAPPED* ov) {
+            return ::ReadFile(_positional.get(), buf.data(), want, nullptr, ov);
+        };
+        if (auto err = overlapped_io(_positional.get(), offset + total, start, nread)) {
+            if (err == ERROR_HANDLE_EOF) {
+                break;
+            }
+            throw_file_error(err, "::ReadFile() on file failed");
+        }
+        if (nread == 0) {
+            break;
+        }
+        total += nread;
+        buf = buf + nread;
+    }
+    return total;
+}
+
+std::size_t native_file::_write_at(const_buffer buf, std::uint64_t offset) {
+    neo_assert(expects, is_open(), "Attempted to write to a closed file", offset, buf.size());
+    if (!_positional.is_open()) {
+        throw_file_error(ERROR_INVALID_FUNCTION, "Positional writes require a regular file");
+    }
+    std::size_t total = 0;
+    while (buf.size()) {
+        DWORD nwritten = 0;
+        auto  want     = static_cast<DWORD>((std::min)(buf.size(), max_io_size));
+        auto  start    = [&](OVERLAPPED* ov) {
+            return ::WriteFile(_positional.get(), buf.data(), want, nullptr, ov);
+        };
+        if (auto err = overlapped_io(_positional.get(), offset + total, start, nwritten)) {
+            throw_file_error(err, "::WriteFile() on file failed");
+        }
+        total += nwritten;
+        buf = buf + nwritten;
+    }
+    return total;
+}
+
+bool native_file::_is_regular() const { return ::GetFileType(get()) == FILE_TYPE_DISK; }
+
+std::size_t native_file::_read_next(mutable_buffer buf) {
+    neo_assert(expects, is_open(), "Attempted to read from a closed file", buf.size());
+    DWORD nread = 0;
+    auto  want  = static_cast<DWORD>((std::min)(buf.size(), max_io_size));
+    if (!::ReadFile(get(), buf.data(), want, &nread, nullptr)) {
+        const auto err = ::GetLastError();
+        if (err == ERROR_BROKEN_PIPE || err == ERROR_HANDLE_EOF) {
+            // The writing end of the pipe has been closed
+            return 0;
+        }
+        throw_file_error(err, "::ReadFile() on file failed");
+    }
+    return static_cast<std::size_t>(nread);
+}
+
+std::uint64_t native_file::size() const {
+    LARGE_INTEGER size;
+    if (!::GetFileSizeEx(get(), &size)) {
+        throw_file_error(::GetLastError(), "::GetFileSizeEx() on file failed");
+    }
+    return static_cast<std::uint64_t>(size.QuadPart);
+}
+
+void native_file::truncate(std::uint64_t size) {
+    FILE_END_OF_FILE_INFO info = {};
+    info.EndOfFile.QuadPart    = static_cast<LONGLONG>(size);
+    if (!::SetFileInformationByHandle(get(), FileEndOfFileInfo, &info, sizeof info)) {
+        throw_file_error(::GetLastError(), "Failed to set the size of a file");
+    }
+}
+
+void native_file::allocate(std::uint64_t offset, std::uint64_t length) {
+    if (size() >= offset + length) {
+        // Setting an allocation size below the end of the file would truncate it
+        return;
+    }
+    FILE_ALLOCATION_INFO info    = {};
+    info.AllocationSize.QuadPart = static_cast<LONGLONG>(offset + length);
+    if (!::SetFileInformationByHandle(get(), FileAllocationInfo, &info, sizeof info)) {
+        throw_file_error(::GetLastError(), "Failed to allocate storage for a file");
+    }
+    truncate(offset + length);
+}
+
+#endif
@@ -18,6 +18,8 @@ struct win32_handle_traits {
     static void        close(handle_type) noexcept;
     static std::size_t write(handle_type h, const_buffer);
     static std::size_t read(handle_type h, mutable_buffer);
+    static void        sync(handle_type h);
+    static void        datasync(handle_type h);
 };
 
 /**
@@ -31,6 +33,8 @@ struct posix_fd_traits {
     static void        close(handle_type) noexcept;
     static std::size_t write(handle_type, const_buffer);
     static std::size_t read(handle_type, mutable_buffer);
+    static void        sync(handle_type);
+    static void        datasync(handle_type);
 };
 
 /**
@@ -104,6 +108,22 @@ public:
         return h;
     }
 
+    /**
+     * @brief Flush the data and metadata of the underlying file to the storage device, so that
+     * they survive a crash or power loss.
+     *
+     * @throws std::system_error if the OS fails to flush the file
+     */
+    void sync() { Traits::sync(get()); }
+
+    /**
+     * @brief Flush the data of the underlying file to the storage device, as with sync(), but
+     * skip metadata that is not required to read the data back (e.g. the modification time).
+     *
+     * @note On platforms that do not distinguish the two, this is equivalent to sync()
+     */
+    void datasync() { Traits::datasync(get()); }
+
 private:
     std::size_t do_write(const_buffer cbuf) override {
         auto n = Traits::write(get(), cbuf);
@@ -146,6 +166,8 @@ public:
     using native_io_stream::is_open;
     using native_io_stream::read;
     using native_io_stream::read_into;
+    using native_io_stream::sync;
+    using native_io_stream::datasync;
     using native_io_stream::write;
 };
 
@@ -6,6 +6,7 @@ using namespace btr;
 
 #if !_WIN32
 
+#include <fcntl.h>
 #include <unistd.h>
 
 void posix_fd_traits::close(int fd) noexcept { ::close(fd); }
@@ -35,4 +36,30 @@ std::size_t posix_fd_traits::read(int fd, mutable_buffer buf) {
     return static_cast<std::size_t>(nread);
 }
 
+void posix_fd_traits::sync(int fd) {
+    neo_assert(expects, fd != null_handle, "Attempted to sync a closed file descriptor");
+#if __APPLE__
+    // fsync() on macOS does not flush the drive's own cache. F_FULLFSYNC does, but is not supported
+    // by every filesystem.
+    if (::fcntl(fd, F_FULLFSYNC) == 0) {
+        return;
+    }
+#endif
+    if (::fsync(fd) != 0) {
+        throw_current_error("::fsync() on file descriptor failed");
+    }
+}
+
+void posix_fd_traits::datasync(int fd) {
+    neo_assert(expects, fd != null_handle, "Attempted to sync a closed file descriptor");
+#if __APPLE__
+    // macOS has no fdatasync()
+    sync(fd);
+#else
+    if (::fdatasync(fd) != 0) {
+        throw_current_error("::fdatasync() on file descriptor failed");
+    }
+#endif
+}
+
 #endif
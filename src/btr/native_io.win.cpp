@@ -37,4 +37,16 @@ std::size_t win32_handle_traits::read(HANDLE h, mutable_buffer buf) {
     return static_cast<std::size_t>(nread);
 }
 
+void win32_handle_traits::sync(HANDLE h) {
+    neo_assert(expects, h != null_handle, "Attempted to sync a closed HANDLE");
+    if (!::FlushFileBuffers(h)) {
+        throw_current_error("::FlushFileBuffers() failed");
+    }
+}
+
+void win32_handle_traits::datasync(HANDLE h) {
+    // Windows does not distinguish data and metadata flushes
+    sync(h);
+}
+
 #endif
@@ -13,13 +13,33 @@ template <typename Func>
 fs::path env_path_or(std::string_view key, Func&& fn) {
     auto found = btr::getenv(key);
     if (found) {
-        return fs::absolute(*found);
+        return fs::absolute(found->path());
+    }
+    return fn();
+}
+
+template <typename Func>
+fs::path xdg_path_or(std::string_view key, Func&& fn) {
+    auto found = paths_detail::xdg_dir(key);
+    if (found) {
+        return *found;
     }
     return fn();
 }
 
 }  // namespace
 
+std::optional<fs::path> btr::paths_detail::xdg_dir(std::string_view key) {
+    auto found = btr::getenv(key);
+    if (found) {
+        auto path = found->path();
+        if (path.is_absolute()) {
+            return path;
+        }
+    }
+    return std::nullopt;
+}
+
 const fs::path& btr::user_home_dir() noexcept {
     static auto ret = []() -> fs::path {
         if (neo::os_is_unix_like) {
@@ -36,7 +56,7 @@ const fs::path& btr::user_home_dir() noexcept {
 const fs::path& btr::user_data_dir() noexcept {
     static auto ret = []() -> fs::path {
         if (neo::os_is_unix_like) {
-            return env_path_or("XDG_DATA_HOME", [] {
+            return xdg_path_or("XDG_DATA_HOME", [] {
                 if (neo::os_is_macos) {
                     return user_home_dir() / "Library/Application Support";
                 } else {
@@ -55,7 +75,7 @@ const fs::path& btr::user_data_dir() noexcept {
 const fs::path& btr::user_cache_dir() noexcept {
     static auto ret = []() -> fs::path {
         if (neo::os_is_unix_like) {
-            return env_path_or("XDG_DATA_HOME", [] {
+            return xdg_path_or("XDG_CACHE_HOME", [] {
                 if (neo::os_is_macos) {
                     return user_home_dir() / "Library/Caches";
                 } else {
@@ -74,11 +94,11 @@ const fs::path& btr::user_cache_dir() noexcept {
 const fs::path& btr::user_config_dir() noexcept {
     static auto ret = []() -> fs::path {
         if (neo::os_is_unix_like) {
-            return env_path_or("XDG_DATA_HOME", [] {
+            return xdg_path_or("XDG_CONFIG_HOME", [] {
                 if (neo::os_is_macos) {
                     return user_home_dir() / "Library/Preferences";
                 } else {
-                    return user_home_dir() / ".cache";
+                    return user_home_dir() / ".config";
                 }
             });
         } else if (neo::os_is_windows) {
@@ -89,3 +109,45 @@ const fs::path& btr::user_config_dir() noexcept {
     }();
     return ret;
 }
+
+const fs::path& btr::user_state_dir() noexcept {
+    static auto ret = []() -> fs::path {
+        if (neo::os_is_unix_like) {
+            return xdg_path_or("XDG_STATE_HOME", [] {
+                if (neo::os_is_macos) {
+                    return user_home_dir() / "Library/Application Support";
+                } else {
+                    return user_home_dir() / ".local/state";
+                }
+            });
+        } else if (neo::os_is_windows) {
+            return env_path_or("LocalAppData", [] { return "/"; });
+        } else {
+            return "/";
+        }
+    }();
+    return ret;
+}
+
+const fs::path& btr::user_runtime_dir() noexcept {
+    static auto ret = []() -> fs::path {
+        if (neo::os_is_unix_like && !neo::os_is_macos) {
+            return xdg_path_or("XDG_RUNTIME_DIR", [] { return temp_dir(); });
+        } else {
+            return temp_dir();
+        }
+    }();
+    return ret;
+}
+
+const fs::path& btr::temp_dir() noexcept {
+    static auto ret = []() -> fs::path {
+        std::error_code ec;
+        auto            dir = fs::temp_directory_path(ec);
+        if (!ec) {
+            return dir;
+        }
+        return neo::os_is_windows ? "/" : "/tmp";
+    }();
+    return ret;
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <filesystem>
+#include <optional>
+#include <string_view>
 
 namespace btr {
 
@@ -25,4 +27,38 @@ const std::filesystem::path& user_cache_dir() noexcept;
  */
 const std::filesystem::path& user_config_dir() noexcept;
 
+/**
+ * @brief Get the path to a directory where applications should store user-specific state that
+ * should persist between restarts, but is not important enough to be kept with the user's data
+ * (e.g. history and logs).
+ */
+const std::filesystem::path& user_state_dir() noexcept;
+
+/**
+ * @brief Get the path to a directory where applications should store user-specific runtime files,
+ * such as sockets and small temporary files.
+ *
+ * On Linux this is `$XDG_RUNTIME_DIR`, which is usually backed by memory, and is removed when the
+ * user logs out. If it is not set, or on other platforms, this is the temp_dir().
+ */
+const std::filesystem::path& user_runtime_dir() noexcept;
+
+/**
+ * @brief Get the path to a directory suitable for temporary files.
+ */
+const std::filesystem::path& temp_dir() noexcept;
+
+namespace paths_detail {
+
+/**
+ * @brief Get the directory named by the XDG base directory variable `key`, if it is set. As
+ * required by the XDG Base Directory Specification, a variable that is empty or holds a relative
+ * path is ignored.
+ *
+ * Unlike the functions above, the result is not cached.
+ */
+std::optional<std::filesystem::path> xdg_dir(std::string_view key);
+
+}  // namespace paths_detail
+
 }  // namespace btr
@@ -0,0 +1,47 @@
+#include "./paths.hpp"
+
+#include "./environ.hpp"
+
+#include <catch2/catch.hpp>
+
+#include <neo/platform.hpp>
+
+TEST_CASE("Get user directories") {
+    CHECK(btr::user_home_dir().is_absolute());
+    CHECK(btr::user_data_dir().is_absolute());
+    CHECK(btr::user_cache_dir().is_absolute());
+    CHECK(btr::user_config_dir().is_absolute());
+    CHECK(btr::user_state_dir().is_absolute());
+    CHECK(btr::user_runtime_dir().is_absolute());
+    CHECK(btr::temp_dir().is_absolute());
+}
+
+TEST_CASE("Read XDG base directory variables") {
+    auto key = GENERATE("XDG_CACHE_HOME", "XDG_CONFIG_HOME", "XDG_DATA_HOME", "XDG_STATE_HOME");
+    INFO("Variable: " << key);
+    auto restore = btr::getenv(key);
+
+    btr::unsetenv(key);
+    CHECK_FALSE(btr::paths_detail::xdg_dir(key));
+
+    // An empty value is ignored
+    btr::setenv(key, "");
+    CHECK_FALSE(btr::paths_detail::xdg_dir(key));
+
+    // A relative path is ignored
+    btr::setenv(key, "relative/dir");
+    CHECK_FALSE(btr::paths_detail::xdg_dir(key));
+
+    // An absolute path is used as-is
+    const auto abs_dir = neo::os_is_windows ? "C:/btr-test/dir" : "/btr-test/dir";
+    btr::setenv(key, abs_dir);
+    auto found = btr::paths_detail::xdg_dir(key);
+    REQUIRE(found);
+    CHECK(*found == abs_dir);
+
+    if (restore) {
+        btr::setenv(key, *restore);
+    } else {
+        btr::unsetenv(key);
+    }
+}
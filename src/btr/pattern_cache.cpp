@@ -0,0 +1,138 @@
+#include "./pattern_cache.hpp"
+
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <variant>
+
+using namespace btr;
+namespace fs = std::filesystem;
+
+namespace {
+
+using cached_pattern = std::variant<fnmatch_pattern, glob>;
+
+/**
+ * Build the lookup key for a pattern. The key encodes the kind of pattern and its options, so that
+ * a glob and an fnmatch pattern with the same spelling (or an fnmatch pattern compiled with
+ * different options) occupy different entries.
+ */
+std::string make_key(char kind, const fnmatch_options& opts, std::u8string_view spelling) {
+    std::string key;
+    key.reserve(spelling.size() + 2);
+    key.push_back(kind);
+    key.push_back(static_cast<char>('0'                               //
+                                    + (opts.case_insensitive ? 1 : 0)  //
+                                    + (opts.leading_period ? 2 : 0)    //
+                                    + (opts.pathname ? 4 : 0)));
+    key.append(reinterpret_cast<const char*>(spelling.data()), spelling.size());
+    return key;
+}
+
+}  // namespace
+
+class pattern_cache::impl {
+    struct entry {
+        std::string    key;
+        cached_pattern pattern;
+    };
+
+    using entry_list = std::list<entry>;
+
+    const std::size_t _capacity;
+
+    mutable std::mutex _mtx;
+    /// Entries, ordered from most-recently-used to least-recently-used
+    entry_list _entries;
+    /// Index of the entries, keyed by views of the key strings in the entries
+    std::unordered_map<std::string_view, entry_list::iterator> _index;
+
+    std::atomic<std::uint64_t> _hits{0};
+    std::atomic<std::uint64_t> _misses{0};
+
+public:
+    explicit impl(std::size_t capacity)
+        : _capacity(capacity) {}
+
+    std::size_t capacity() const noexcept { return _capacity; }
+
+    template <typename Pattern, typename Compile>
+    Pattern get(std::string key, Compile&& compile) {
+        {
+            std::unique_lock lk{_mtx};
+            auto             found = _index.find(key);
+            if (found != _index.end()) {
+                // Move the entry to the front of the list
+                _entries.splice(_entries.begin(), _entries, found->second);
+                _hits.fetch_add(1, std::memory_order_relaxed);
+                return std::get<Pattern>(found->second->pattern);
+            }
+        }
+        _misses.fetch_add(1, std::memory_order_relaxed);
+        // Compile without holding the lock, so that other threads are not blocked
+        Pattern ret = compile();
+        if (_capacity == 0) {
+            return ret;
+        }
+        std::unique_lock lk{_mtx};
+        if (_index.find(key) != _index.end()) {
+            // Another thread inserted the same pattern while we were compiling it
+            return ret;
+        }
+        if (_entries.size() == _capacity) {
+            _index.erase(_entries.back().key);
+            _entries.pop_back();
+        }
+        _entries.push_front(entry{std::move(key), ret});
+        _index.emplace(_entries.front().key, _entries.begin());
+        return ret;
+    }
+
+    pattern_cache_stats stats() const noexcept {
+        pattern_cache_stats ret;
+        ret.hits   = _hits.load(std::memory_order_relaxed);
+        ret.misses = _misses.load(std::memory_order_relaxed);
+        std::unique_lock lk{_mtx};
+        ret.size = _entries.size();
+        return ret;
+    }
+
+    void clear() noexcept {
+        std::unique_lock lk{_mtx};
+        _index.clear();
+        _entries.clear();
+    }
+};
+
+pattern_cache::pattern_cache(std::size_t capacity)
+    : _impl(std::make_shared<impl>(capacity)) {}
+
+pattern_cache& pattern_cache::global() noexcept {
+    static pattern_cache inst;
+    return inst;
+}
+
+fnmatch_pattern pattern_cache::compile_fnmatch(u8view spelling, const fnmatch_options& opts) {
+    return _impl->get<fnmatch_pattern>(make_key('f', opts, spelling.u8string_view()), [&] {
+        return fnmatch_pattern::compile(spelling, opts);
+    });
+}
+
+glob pattern_cache::compile_glob(const fs::path& spelling) {
+    const auto str = spelling.u8string();
+    return _impl->get<glob>(make_key('g', {}, str), [&] { return glob::compile(spelling); });
+}
+
+std::size_t         pattern_cache::capacity() const noexcept { return _impl->capacity(); }
+pattern_cache_stats pattern_cache::stats() const noexcept { return _impl->stats(); }
+void                pattern_cache::clear() noexcept { _impl->clear(); }
+
+bool btr::fnmatch(u8view pattern, u8view string) {
+    return pattern_cache::global().compile_fnmatch(pattern).test(string.u8string_view());
+}
+
+bool btr::fnmatch(u8view pattern, u8view string, const fnmatch_options& opts) {
+    return pattern_cache::global().compile_fnmatch(pattern, opts).test(string.u8string_view());
+}
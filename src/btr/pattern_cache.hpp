@@ -0,0 +1,73 @@
+#pragma once
+
+#include "./fnmatch.hpp"
+#include "./glob.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+
+namespace btr {
+
+/**
+ * @brief A snapshot of the usage counters of a pattern_cache
+ */
+struct pattern_cache_stats {
+    /// The number of lookups that found an already-compiled pattern
+    std::uint64_t hits = 0;
+    /// The number of lookups that needed to compile a pattern
+    std::uint64_t misses = 0;
+    /// The number of patterns currently held in the cache
+    std::size_t size = 0;
+};
+
+/**
+ * @brief A bounded cache of compiled fnmatch_pattern and glob objects, keyed by their spelling.
+ *
+ * When the cache is full, the least-recently-used pattern is evicted to make room for a new one.
+ * A pattern_cache may be used from multiple threads simultaneously. Copies of a pattern_cache
+ * refer to the same underlying cache.
+ *
+ * Compiling a malformed pattern throws the same exception as compiling the pattern directly, and
+ * nothing is added to the cache.
+ */
+class pattern_cache {
+    class impl;
+    std::shared_ptr<impl> _impl;
+
+public:
+    /// The capacity of a default-constructed pattern_cache, and of the global() cache
+    static constexpr std::size_t default_capacity = 256;
+
+    /**
+     * @brief Create a new empty cache
+     *
+     * @param capacity The maximum number of patterns to hold at once. If zero, no patterns are
+     *      retained, and every lookup compiles a new pattern.
+     */
+    explicit pattern_cache(std::size_t capacity = default_capacity);
+
+    /**
+     * @brief Obtain the global pattern cache. This is the cache used by the btr::fnmatch() free
+     * functions.
+     */
+    [[nodiscard]] static pattern_cache& global() noexcept;
+
+    /// Obtain a compiled fnmatch_pattern for the given spelling and options
+    [[nodiscard]] fnmatch_pattern compile_fnmatch(u8view                 spelling,
+                                                  const fnmatch_options& opts = {});
+
+    /// Obtain a compiled glob for the given spelling
+    [[nodiscard]] glob compile_glob(const std::filesystem::path& spelling);
+
+    /// Get the maximum number of patterns that the cache will hold
+    [[nodiscard]] std::size_t capacity() const noexcept;
+
+    /// Obtain the current usage counters of the cache
+    [[nodiscard]] pattern_cache_stats stats() const noexcept;
+
+    /// Remove all patterns from the cache. The hit and miss counters are not reset.
+    void clear() noexcept;
+};
+
+}  // namespace btr
@@ -0,0 +1,92 @@
+#include <btr/pattern_cache.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Cache compiled patterns") {
+    btr::pattern_cache cache{2};
+    CHECK(cache.capacity() == 2);
+
+    auto pat = cache.compile_fnmatch("*.cpp");
+    CHECK(pat.test("foo.cpp"));
+    CHECK(cache.stats().misses == 1);
+    CHECK(cache.stats().hits == 0);
+
+    pat = cache.compile_fnmatch("*.cpp");
+    CHECK(pat.test("bar.cpp"));
+    CHECK(cache.stats().misses == 1);
+    CHECK(cache.stats().hits == 1);
+
+    // Different options give a different pattern
+    pat = cache.compile_fnmatch("*.cpp", {.case_insensitive = true});
+    CHECK(pat.test("BAR.CPP"));
+    CHECK(cache.stats().misses == 2);
+    CHECK(cache.stats().size == 2);
+
+    // A glob with the same spelling is also a different pattern. "*.cpp" (with no options) is the
+    // least-recently-used entry, and is evicted.
+    auto glb = cache.compile_glob("*.cpp");
+    CHECK(glb.test("baz.cpp"));
+    CHECK(cache.stats().misses == 3);
+    CHECK(cache.stats().size == 2);
+
+    pat = cache.compile_fnmatch("*.cpp", {.case_insensitive = true});
+    CHECK(cache.stats().hits == 2);
+    pat = cache.compile_fnmatch("*.cpp");
+    CHECK(cache.stats().misses == 4);
+
+    // Bad patterns throw, and are not cached
+    CHECK_THROWS_AS(cache.compile_fnmatch("[foo"), btr::bad_fnmatch_pattern);
+    CHECK_THROWS_AS(cache.compile_fnmatch("[foo"), btr::bad_fnmatch_pattern);
+    CHECK(cache.stats().misses == 6);
+    CHECK(cache.stats().size == 2);
+
+    cache.clear();
+    CHECK(cache.stats().size == 0);
+    CHECK(cache.stats().hits == 2);
+
+    // A cache with no capacity holds nothing
+    btr::pattern_cache none{0};
+    CHECK(none.compile_fnmatch("*.cpp").test("foo.cpp"));
+    CHECK(none.compile_fnmatch("*.cpp").test("foo.cpp"));
+    CHECK(none.stats().misses == 2);
+    CHECK(none.stats().size == 0);
+}
+
+TEST_CASE("The fnmatch() free function uses the global cache") {
+    auto& cache  = btr::pattern_cache::global();
+    auto  before = cache.stats();
+    for (int i = 0; i < 10; ++i) {
+        CHECK(btr::fnmatch("*.test-global-cache", "foo.test-global-cache"));
+    }
+    auto after = cache.stats();
+    CHECK(after.misses == before.misses + 1);
+    CHECK(after.hits == before.hits + 9);
+}
+
+TEST_CASE("Use a pattern cache from many threads") {
+    btr::pattern_cache cache{8};
+
+    std::vector<std::thread> threads;
+    std::atomic<int>         n_matched = 0;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&] {
+            for (int n = 0; n < 1000; ++n) {
+                auto spelling = "*." + std::to_string(n % 16);
+                if (cache.compile_fnmatch(spelling).test("foo." + std::to_string(n % 16))) {
+                    ++n_matched;
+                }
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    CHECK(n_matched == 4000);
+    CHECK(cache.stats().size == 8);
+    CHECK(cache.stats().hits + cache.stats().misses == 4000);
+}
@@ -0,0 +1,175 @@
+#include "./read_files.hpp"
+
+#include "./native_file.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+using namespace btr;
+namespace fs = std::filesystem;
+
+namespace {
+
+/**
+ * Shared state of the threads of a read_files() call
+ */
+class file_reader {
+    std::span<const fs::path>                     _paths;
+    const std::function<void(read_file_result&)>& _on_read;
+    const std::uint64_t                           _max_pending;
+
+    /// The index of the next file to be read
+    std::atomic<std::size_t> _next{0};
+    /// Set when the callback throws, to stop the readers
+    std::atomic<bool> _stop{false};
+
+    std::mutex              _budget_mtx;
+    std::condition_variable _budget_cv;
+    /// The number of bytes that have been reserved for reading and not yet handed to the callback
+    std::uint64_t _pending = 0;
+
+    /// Serializes calls to the callback
+    std::mutex         _callback_mtx;
+    std::exception_ptr _callback_error;
+
+    void _acquire(std::uint64_t nbytes) {
+        std::unique_lock lk{_budget_mtx};
+        _budget_cv.wait(lk, [&] {
+            return _pending == 0 || (_pending <= _max_pending && nbytes <= _max_pending - _pending)
+                || _stop.load();
+        });
+        _pending += nbytes;
+    }
+
+    void _release(std::uint64_t nbytes) {
+        {
+            std::unique_lock lk{_budget_mtx};
+            _pending -= nbytes;
+        }
+        _budget_cv.notify_all();
+    }
+
+    /// Replace a reservation with the number of bytes that were actually used
+    void _adjust(std::uint64_t reserved, std::uint64_t used) {
+        {
+            std::unique_lock lk{_budget_mtx};
+            _pending = _pending - reserved + used;
+        }
+        if (used < reserved) {
+            _budget_cv.notify_all();
+        }
+    }
+
+    void _read_one(std::size_t index) {
+        read_file_result result;
+        result.index           = index;
+        std::uint64_t reserved = 0;
+        try {
+            auto f = native_file::open(_paths[index], {.no_access_time = true});
+            // read_all() allocates one byte more than the file's size, and more if the file has
+            // grown or is a stream. The content is accounted for once its size is known.
+            reserved = f.size() + 1;
+            _acquire(reserved);
+            result.content  = f.read_all();
+            const auto used = result.content.capacity();
+            _adjust(reserved, used);
+            reserved = used;
+        } catch (...) {
+            result.content.clear();
+            result.error = std::current_exception();
+        }
+
+        {
+            std::unique_lock lk{_callback_mtx};
+            if (!_stop.load()) {
+                try {
+                    _on_read(result);
+                } catch (...) {
+                    _callback_error = std::current_exception();
+                    _stop.store(true);
+                    _budget_cv.notify_all();
+                }
+            }
+        }
+        // Free the content before releasing its budget
+        result = {};
+        _release(reserved);
+    }
+
+public:
+    file_reader(std::span<const fs::path>                     paths,
+                const std::function<void(read_file_result&)>& on_read,
+                std::uint64_t                                 max_pending)
+        : _paths(paths)
+        , _on_read(on_read)
+        , _max_pending(max_pending) {}
+
+    /// Read files until none remain. Called on each reading thread.
+    void run() noexcept {
+        while (!_stop.load()) {
+            auto index = _next.fetch_add(1);
+            if (index >= _paths.size()) {
+                break;
+            }
+            _read_one(index);
+        }
+    }
+
+    void rethrow_if_failed() const {
+        if (_callback_error) {
+            std::rethrow_exception(_callback_error);
+        }
+    }
+};
+
+}  // namespace
+
+void btr::read_files(std::span<const fs::path>                     paths,
+                     const std::function<void(read_file_result&)>& on_read,
+                     read_files_options                            opts) {
+    auto nthreads = opts.max_threads;
+    if (nthreads == 0) {
+        nthreads = (std::max)(std::thread::hardware_concurrency(), 1u);
+    }
+    nthreads = (std::min)(nthreads, paths.size());
+
+    file_reader reader{paths, on_read, opts.max_pending_bytes};
+    if (nthreads <= 1) {
+        // Don't bother with another thread
+        reader.run();
+    } else {
+        std::vector<std::thread> threads;
+        threads.reserve(nthreads - 1);
+        for (auto i = 1u; i < nthreads; ++i) {
+            try {
+                threads.emplace_back([&] { reader.run(); });
+            } catch (const std::system_error&) {
+                // Out of threads. Make do with the ones we have.
+                break;
+            }
+        }
+        // The calling thread reads too
+        reader.run();
+        for (auto& thr : threads) {
+            thr.join();
+        }
+    }
+    reader.rethrow_if_failed();
+}
+
+std::vector<read_file_result> btr::read_files(std::span<const fs::path> paths,
+                                              read_files_options        opts) {
+    std::vector<read_file_result> results;
+    results.resize(paths.size());
+    // Each result is stored by the callback, so nothing is pending for long
+    opts.max_pending_bytes = UINT64_MAX;
+    read_files(
+        paths,
+        [&](read_file_result& res) { results[res.index] = std::move(res); },
+        opts);
+    return results;
+}
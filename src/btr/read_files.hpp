@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace btr {
+
+/**
+ * @brief The result of reading one of the files given to read_files()
+ */
+struct read_file_result {
+    /// The index of the file in the list of paths given to read_files()
+    std::size_t index = 0;
+    /// The content of the file, if it was read successfully
+    std::string content;
+    /// The exception that was thrown while reading the file, if any (usually a file_error)
+    std::exception_ptr error;
+
+    /// Determine whether the file was read successfully
+    [[nodiscard]] bool successful() const noexcept { return !error; }
+
+    /// If reading the file failed, rethrow the exception that caused the failure
+    void throw_if_error() const {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+};
+
+/**
+ * @brief Options for read_files()
+ */
+struct read_files_options {
+    /**
+     * @brief The maximum number of threads that will read files. If zero, use the number of
+     * hardware threads. No more threads are used than there are files.
+     */
+    std::size_t max_threads = 0;
+
+    /**
+     * @brief The maximum number of bytes of file content that have been read but not yet handed to
+     * the callback. Readers wait for the callback to catch up before reading more. A single file
+     * larger than this limit is still read, but only when no other content is pending.
+     */
+    std::uint64_t max_pending_bytes = 256ull * 1024 * 1024;
+};
+
+/**
+ * @brief Read many files concurrently, and pass each to a callback as soon as it has been read.
+ *
+ * @param paths The files to read
+ * @param on_read A callback that receives each result. The callback is invoked on the reading
+ *      threads, but never more than once at a time, and the files are given in the order that they
+ *      were read. The result is discarded when the callback returns, so the callback should move
+ *      the content out if it needs to keep it.
+ * @param opts Options for reading
+ *
+ * Failure to read a file is recorded in its result, and does not stop the other files from being
+ * read. If the callback throws, no further files are read, and the exception is rethrown once the
+ * reading threads have stopped.
+ */
+void read_files(std::span<const std::filesystem::path>       paths,
+                const std::function<void(read_file_result&)>& on_read,
+                read_files_options                            opts = {});
+
+/**
+ * @brief Read many files concurrently.
+ *
+ * @return std::vector<read_file_result> A result for each file, in the same order as `paths`.
+ *
+ * @note The `max_pending_bytes` option has no effect, since every file is retained in the result.
+ */
+[[nodiscard]] std::vector<read_file_result>
+read_files(std::span<const std::filesystem::path> paths, read_files_options opts = {});
+
+}  // namespace btr
@@ -0,0 +1,87 @@
+#include <btr/read_files.hpp>
+
+#include <btr/file.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+/// A fresh directory for a test, removed when the test ends
+struct test_dir {
+    fs::path path;
+
+    explicit test_dir(std::string_view name)
+        : path(fs::current_path() / "_test" / name) {
+        fs::remove_all(path);
+    }
+
+    ~test_dir() {
+        std::error_code ec;
+        fs::remove_all(path, ec);
+    }
+};
+
+std::vector<fs::path> write_test_files(const fs::path& dir, int count) {
+    fs::create_directories(dir);
+    std::vector<fs::path> paths;
+    for (auto i = 0; i < count; ++i) {
+        auto p = dir / (std::to_string(i) + ".txt");
+        btr::file::write(p, std::string(static_cast<std::size_t>(i) * 100, 'a' + (i % 26)));
+        paths.push_back(p);
+    }
+    return paths;
+}
+
+}  // namespace
+
+TEST_CASE("Read many files") {
+    test_dir dir{"read-many"};
+    auto     paths = write_test_files(dir.path, 50);
+    paths.push_back(paths.front().parent_path() / "does-not-exist.txt");
+
+    auto results = btr::read_files(paths, {.max_threads = 4});
+    REQUIRE(results.size() == 51);
+    for (auto i = 0u; i < 50; ++i) {
+        CHECK(results[i].index == i);
+        CHECK(results[i].successful());
+        CHECK(results[i].content == std::string(i * 100, char('a' + (i % 26))));
+    }
+    CHECK_FALSE(results[50].successful());
+    CHECK_THROWS_AS(results[50].throw_if_error(), btr::file_not_found_error);
+}
+
+TEST_CASE("Read files with a callback") {
+    test_dir dir{"read-callback"};
+    auto     paths = write_test_files(dir.path, 50);
+
+    std::set<std::size_t> seen;
+    std::size_t           total = 0;
+    // A small limit on pending bytes still allows every file to be read
+    btr::read_files(
+        paths,
+        [&](btr::read_file_result& res) {
+            res.throw_if_error();
+            seen.insert(res.index);
+            total += res.content.size();
+        },
+        {.max_pending_bytes = 1000});
+    CHECK(seen.size() == 50);
+    CHECK(total == 49 * 50 / 2 * 100);
+
+    // Exceptions from the callback stop reading and are rethrown
+    int count = 0;
+    CHECK_THROWS_AS(btr::read_files(paths,
+                                    [&](btr::read_file_result&) {
+                                        ++count;
+                                        throw std::runtime_error("Stop!");
+                                    }),
+                    std::runtime_error);
+    CHECK(count == 1);
+}
@@ -0,0 +1,335 @@
+#pragma once
+
+#include "./fnmatch.hpp"
+#include "./u8view.hpp"
+#include "./utf.hpp"
+
+#include <neo/utf8.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+namespace btr {
+
+namespace fnmatch_detail {
+
+/**
+ * @brief A string literal that may be used as a template argument
+ */
+template <typename Char, std::size_t N>
+struct fixed_string {
+    char8_t chars[N] = {};
+
+    constexpr fixed_string(const Char (&str)[N]) noexcept {
+        for (std::size_t i = 0; i < N; ++i) {
+            chars[i] = static_cast<char8_t>(str[i]);
+        }
+    }
+
+    /// Get the string, excluding the null terminator
+    constexpr std::u8string_view view() const noexcept { return {chars, N - 1}; }
+};
+
+template <std::size_t N>
+fixed_string(const char (&)[N]) -> fixed_string<char, N>;
+template <std::size_t N>
+fixed_string(const char8_t (&)[N]) -> fixed_string<char8_t, N>;
+
+/**
+ * @brief Report an invalid static_fnmatch pattern.
+ *
+ * This function is deliberately not constexpr: If it is reached while compiling a pattern during
+ * constant evaluation, compilation fails, and the diagnostic will include the reason.
+ */
+[[noreturn]] inline void static_pattern_error(std::u8string_view pattern, const char* reason) {
+    throw bad_fnmatch_pattern(std::string(pattern.begin(), pattern.end()), reason);
+}
+
+enum class static_elem_kind : std::uint8_t {
+    literal,
+    any_char,
+    oneof,
+    noneof,
+    star,
+};
+
+/// A single element of a static pattern. Groups refer to a range of static_pattern::group_chars
+struct static_elem {
+    static_elem_kind kind        = static_elem_kind::literal;
+    char32_t         ch          = 0;
+    std::size_t      group_begin = 0;
+    std::size_t      group_end   = 0;
+};
+
+/**
+ * @brief A pattern compiled at compile-time. `N` is an upper bound on the number of elements and
+ * group codepoints (the length of the pattern in bytes suffices).
+ */
+template <std::size_t N>
+struct static_pattern {
+    static_elem elems[N + 1]       = {};
+    char32_t    group_chars[N + 1] = {};
+    std::size_t n_elems            = 0;
+    std::size_t n_group_chars      = 0;
+
+    fnmatch_shape shape = fnmatch_shape::general;
+    /// The number of literal elements at the beginning and end of the pattern
+    std::size_t n_prefix = 0;
+    std::size_t n_suffix = 0;
+    /// The UTF-8 length of the literal elements at the beginning and end of the pattern
+    std::size_t prefix_len = 0;
+    std::size_t suffix_len = 0;
+
+    constexpr bool accepts_char(const static_elem& el, char32_t c) const noexcept {
+        switch (el.kind) {
+        case static_elem_kind::literal:
+            return c == el.ch;
+        case static_elem_kind::any_char:
+        case static_elem_kind::star:
+            return true;
+        case static_elem_kind::oneof:
+        case static_elem_kind::noneof:
+            for (auto i = el.group_begin; i != el.group_end; ++i) {
+                if (group_chars[i] == c) {
+                    return el.kind == static_elem_kind::oneof;
+                }
+            }
+            return el.kind == static_elem_kind::noneof;
+        }
+        return false;
+    }
+};
+
+/// Get the number of bytes required to encode the given codepoint as UTF-8
+constexpr std::size_t utf8_length(char32_t c) noexcept {
+    return c < 0x80 ? 1 : c < 0x800 ? 2 : c < 0x10000 ? 3 : 4;
+}
+
+/// Compile a pattern. Follows the same grammar as fnmatch_pattern::compile()
+template <std::size_t N>
+constexpr static_pattern<N> compile_static(std::u8string_view spelling) {
+    static_pattern<N> ret;
+    // Decode the pattern up-front
+    char32_t    chars[N + 1] = {};
+    std::size_t n_chars      = 0;
+    for (auto it = spelling.begin(); it != spelling.end();) {
+        auto cp = neo::next_utf8_codepoint(it, spelling.end());
+        if (cp.error() != neo::utf8_errc::none) {
+            static_pattern_error(spelling, "Pattern is not valid UTF-8");
+        }
+        chars[n_chars++] = cp.codepoint;
+        it += static_cast<std::ptrdiff_t>(cp.size);
+    }
+
+    auto push = [&](static_elem_kind kind, char32_t ch = 0) -> static_elem& {
+        auto& el = ret.elems[ret.n_elems++];
+        el.kind  = kind;
+        el.ch    = ch;
+        return el;
+    };
+    auto push_group = [&](static_elem_kind kind, char32_t ch) {
+        auto& el                             = push(kind);
+        el.group_begin                       = ret.n_group_chars;
+        ret.group_chars[ret.n_group_chars++] = ch;
+        el.group_end                         = ret.n_group_chars;
+    };
+
+    if (n_chars && chars[0] == U'!') {
+        static_pattern_error(spelling,
+                             "Patterns starting with a literal exclamation point '!' are reserved. "
+                             "Escape with square brackets [!]");
+    }
+    std::size_t idx = 0;
+    while (idx < n_chars) {
+        const auto c = chars[idx];
+        if (c == U'*') {
+            // Consecutive stars are equivalent to a single star
+            if (ret.n_elems == 0 || ret.elems[ret.n_elems - 1].kind != static_elem_kind::star) {
+                push(static_elem_kind::star);
+            }
+            ++idx;
+        } else if (c == U'?') {
+            push(static_elem_kind::any_char);
+            ++idx;
+        } else if (c != U'[') {
+            push(static_elem_kind::literal, c);
+            ++idx;
+        } else {
+            ++idx;
+            auto has = [&](std::size_t at, char32_t want) {
+                return at < n_chars && chars[at] == want;
+            };
+            if (has(idx, U'!') && has(idx + 1, U']')) {
+                // Special '[!]' matches a single exclamation point
+                push_group(static_elem_kind::oneof, U'!');
+                idx += 2;
+                continue;
+            }
+            auto kind = static_elem_kind::oneof;
+            if (has(idx, U'!')) {
+                kind = static_elem_kind::noneof;
+                ++idx;
+            }
+            if (has(idx, U']') && has(idx + 1, U']')) {
+                push_group(kind, U']');
+                idx += 2;
+                continue;
+            }
+            auto& el       = push(kind);
+            el.group_begin = ret.n_group_chars;
+            while (idx < n_chars && chars[idx] != U']') {
+                ret.group_chars[ret.n_group_chars++] = chars[idx++];
+            }
+            if (idx == n_chars) {
+                static_pattern_error(spelling, "Unterminated [group] in pattern");
+            }
+            el.group_end = ret.n_group_chars;
+            ++idx;
+        }
+    }
+
+    // Classify the shape of the pattern, as for fnmatch_pattern::shape()
+    auto is_literal = [&](std::size_t i) { return ret.elems[i].kind == static_elem_kind::literal; };
+    while (ret.n_prefix < ret.n_elems && is_literal(ret.n_prefix)) {
+        ret.prefix_len += utf8_length(ret.elems[ret.n_prefix++].ch);
+    }
+    if (ret.n_prefix == ret.n_elems) {
+        ret.shape      = fnmatch_shape::exact;
+        ret.n_suffix   = ret.n_prefix;
+        ret.suffix_len = ret.prefix_len;
+        return ret;
+    }
+    while (is_literal(ret.n_elems - ret.n_suffix - 1)) {
+        ret.suffix_len += utf8_length(ret.elems[ret.n_elems - ++ret.n_suffix].ch);
+    }
+    if (ret.n_prefix + ret.n_suffix + 1 != ret.n_elems
+        || ret.elems[ret.n_prefix].kind != static_elem_kind::star) {
+        ret.shape = fnmatch_shape::general;
+    } else if (ret.n_prefix == 0 && ret.n_suffix == 0) {
+        ret.shape = fnmatch_shape::always;
+    } else if (ret.n_suffix == 0) {
+        ret.shape = fnmatch_shape::prefix;
+    } else if (ret.n_prefix != 0) {
+        ret.shape = fnmatch_shape::prefix_suffix;
+    } else {
+        bool is_ext = ret.elems[ret.n_prefix + 1].ch == U'.';
+        for (auto i = ret.n_prefix + 2; i < ret.n_elems; ++i) {
+            is_ext = is_ext && ret.elems[i].ch != U'.';
+        }
+        ret.shape = is_ext ? fnmatch_shape::extension : fnmatch_shape::suffix;
+    }
+    return ret;
+}
+
+/**
+ * @brief Match a string against a static pattern.
+ *
+ * Because every element other than a star consumes exactly one codepoint, it is sufficient to
+ * remember only the most recent star and retry from there on a mismatch. This requires no
+ * allocation and takes at most O(n*m) steps.
+ */
+template <std::size_t N>
+constexpr bool match_static(const static_pattern<N>& pat, std::u8string_view str) noexcept {
+    constexpr auto no_star = ~std::size_t(0);
+
+    std::size_t pos       = 0;
+    std::size_t elem      = 0;
+    std::size_t star_elem = no_star;
+    std::size_t star_pos  = 0;
+    while (pos != str.size()) {
+        if (elem < pat.n_elems && pat.elems[elem].kind == static_elem_kind::star) {
+            // Begin by matching the star with an empty string
+            star_elem = elem++;
+            star_pos  = pos;
+            continue;
+        }
+        auto cp = neo::next_utf8_codepoint(str.begin() + static_cast<std::ptrdiff_t>(pos),
+                                           str.end());
+        if (cp.error() != neo::utf8_errc::none) {
+            // Invalid UTF-8 never matches
+            return false;
+        }
+        if (elem < pat.n_elems && pat.accepts_char(pat.elems[elem], cp.codepoint)) {
+            ++elem;
+            pos += cp.size;
+            continue;
+        }
+        if (star_elem == no_star) {
+            return false;
+        }
+        // Extend the most recent star by one more codepoint, and try again
+        elem = star_elem + 1;
+        star_pos += neo::next_utf8_codepoint(str.begin() + static_cast<std::ptrdiff_t>(star_pos),
+                                             str.end())
+                        .size;
+        pos = star_pos;
+    }
+    while (elem < pat.n_elems && pat.elems[elem].kind == static_elem_kind::star) {
+        ++elem;
+    }
+    return elem == pat.n_elems;
+}
+
+}  // namespace fnmatch_detail
+
+/**
+ * @brief An fnmatch pattern that is compiled and validated at compile-time.
+ *
+ * Has the same syntax and semantics as fnmatch_pattern, but requires no allocation and is matched
+ * by code that is fully visible to the compiler. An invalid pattern is a compile-time error.
+ *
+ * @tparam Pattern A string literal fnmatch pattern, e.g. `btr::static_fnmatch<"*.cpp">`
+ */
+template <fnmatch_detail::fixed_string Pattern>
+class static_fnmatch {
+    static constexpr auto _pattern
+        = fnmatch_detail::compile_static<Pattern.view().size()>(Pattern.view());
+
+public:
+    /// Get the original spelling of the pattern
+    [[nodiscard]] static constexpr std::u8string_view literal_spelling() noexcept {
+        return Pattern.view();
+    }
+
+    /// Get the shape of the pattern
+    [[nodiscard]] static constexpr fnmatch_shape shape() noexcept { return _pattern.shape; }
+
+    /**
+     * @brief Test whether the given string matches the pattern.
+     *
+     * @param string Any string or string-like object.
+     * @return true If the string matches the pattern
+     * @return false Otherwise
+     */
+    [[nodiscard]] static constexpr bool test(u8view string) noexcept {
+        const auto str    = string.u8string_view();
+        const auto spell  = Pattern.view();
+        const auto prefix = spell.substr(0, _pattern.prefix_len);
+        const auto suffix = spell.substr(spell.size() - _pattern.suffix_len);
+        if constexpr (_pattern.shape == fnmatch_shape::exact) {
+            return str == spell;
+        } else if constexpr (_pattern.shape == fnmatch_shape::general) {
+            return fnmatch_detail::match_static(_pattern, str);
+        } else {
+            if (std::is_constant_evaluated()) {
+                // btr::validate_utf8() cannot run at compile time, but the general matcher can
+                return fnmatch_detail::match_static(_pattern, str);
+            }
+            // Literal text with a single star, which matches any valid UTF-8
+            return str.size() >= prefix.size() + suffix.size()  //
+                && str.starts_with(prefix)                      //
+                && str.ends_with(suffix)                        //
+                && validate_utf8(
+                       str.substr(prefix.size(), str.size() - prefix.size() - suffix.size()));
+        }
+    }
+
+    /// Obtain an equivalent runtime fnmatch_pattern
+    [[nodiscard]] static fnmatch_pattern to_pattern() {
+        return fnmatch_pattern::compile(literal_spelling());
+    }
+};
+
+}  // namespace btr
@@ -0,0 +1,82 @@
+#include <btr/static_fnmatch.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <string_view>
+
+static_assert(btr::static_fnmatch<"*.cpp">::test(u8"foo.cpp"));
+static_assert(!btr::static_fnmatch<"*.cpp">::test(u8"foo.hpp"));
+static_assert(btr::static_fnmatch<"*.cpp">::shape() == btr::fnmatch_shape::extension);
+static_assert(btr::static_fnmatch<"lib*.so">::shape() == btr::fnmatch_shape::prefix_suffix);
+static_assert(btr::static_fnmatch<"main.cpp">::shape() == btr::fnmatch_shape::exact);
+static_assert(btr::static_fnmatch<"*a*b">::shape() == btr::fnmatch_shape::general);
+static_assert(btr::static_fnmatch<"*a*b">::test(u8"xaxxbxb"));
+static_assert(!btr::static_fnmatch<"*a*b">::test(u8"xaxxbxc"));
+static_assert(btr::static_fnmatch<u8"Кири[!л]лица">::test(u8"Кириqлица"));
+
+namespace {
+
+template <btr::fnmatch_detail::fixed_string Pattern>
+void check_same_as_runtime() {
+    using static_pattern      = btr::static_fnmatch<Pattern>;
+    const auto        dynamic = static_pattern::to_pattern();
+    const std::string strings[] = {
+        "",
+        "foo",
+        "foo.cpp",
+        "foo.hpp",
+        ".cpp",
+        "a",
+        "ab",
+        "abc",
+        "aabbcc",
+        "main.cpp",
+        "libfoo.so",
+        "lib.so",
+        "!",
+        "]",
+        "Кириqлица",
+        "foo\xff.cpp",
+        "\xc3",
+    };
+    CHECK(static_pattern::shape() == dynamic.shape());
+    for (auto& str : strings) {
+        CAPTURE(dynamic.literal_spelling(), str);
+        CHECK(static_pattern::test(str) == dynamic.test(str));
+    }
+}
+
+}  // namespace
+
+TEST_CASE("Static patterns match the same as runtime patterns") {
+    check_same_as_runtime<"*.cpp">();
+    check_same_as_runtime<"*">();
+    check_same_as_runtime<"">();
+    check_same_as_runtime<"main.cpp">();
+    check_same_as_runtime<"main.*">();
+    check_same_as_runtime<"lib*.so">();
+    check_same_as_runtime<"*.?pp">();
+    check_same_as_runtime<"a*b*c">();
+    check_same_as_runtime<"*a*">();
+    check_same_as_runtime<"?">();
+    check_same_as_runtime<"[ab]*">();
+    check_same_as_runtime<"[!ab]*">();
+    check_same_as_runtime<"[!]">();
+    check_same_as_runtime<"[]]">();
+    check_same_as_runtime<"[!]]">();
+    check_same_as_runtime<u8"Кири[!л]лица">();
+    check_same_as_runtime<"*a*b*c*">();
+}
+
+TEST_CASE("Static patterns are usable at runtime") {
+    std::string_view str = "build/foo.o";
+    CHECK(btr::static_fnmatch<"*.o">::test(str));
+    CHECK_FALSE(btr::static_fnmatch<"*.cpp">::test(str));
+    CHECK(btr::static_fnmatch<"*.cpp">::literal_spelling() == u8"*.cpp");
+
+    // Static patterns only backtrack to the latest star, so this does not take exponential time
+    const std::string many_a(100'000, 'a');
+    CHECK_FALSE(btr::static_fnmatch<"*a*a*a*a*a*a*a*a*a*a*b">::test(many_a));
+    CHECK(btr::static_fnmatch<"*a*a*a*a*a*a*a*a*a*a*b">::test(many_a + "b"));
+}
@@ -64,9 +64,9 @@ bool btr::argv_arg_needs_quoting(u8view arg) noexcept {
     return !all_okay;
 }
 
-std::string btr::quote_argv_arg(u8view arg) noexcept {
+btr::u8string btr::quote_argv_arg(u8view arg) noexcept {
     if (!argv_arg_needs_quoting(arg)) {
-        return std::string(arg);
+        return btr::u8string(arg);
     }
     codepoint_range cps{arg.u8string_view()};
     std::u32string  r;
@@ -79,7 +79,7 @@ std::string btr::quote_argv_arg(u8view arg) noexcept {
             r.push_back(c);
         }
     }
-    return u8_as_char_encode(r);
+    return btr::u8string(u8encode(r));
 }
 
 void btr::subprocess::_repr_into(std::string& out) const noexcept {
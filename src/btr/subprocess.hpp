@@ -2,6 +2,7 @@
 
 #include "./pipe.hpp"
 #include "./subprocess_fwd.hpp"
+#include "./u8string.hpp"
 #include "./u8view.hpp"
 
 #include <neo/assert.hpp>
@@ -488,15 +489,15 @@ subprocess subprocess::_spawn_cmd(R&& r) {
     return spawn(opts);
 }
 
-bool        argv_arg_needs_quoting(u8view arg) noexcept;
-std::string quote_argv_arg(u8view arg) noexcept;
+bool          argv_arg_needs_quoting(u8view arg) noexcept;
+btr::u8string quote_argv_arg(u8view arg) noexcept;
 
 template <std::ranges::input_range R>
 requires std::convertible_to<std::ranges::range_value_t<R>, u8view>  //
     std::string quote_argv_string(R&& r) noexcept {
     std::string acc;
     for (u8view arg : r) {
-        acc.append(quote_argv_arg(arg));
+        acc.append(quote_argv_arg(arg).string_view());
         acc.push_back(' ');
     }
     if (!acc.empty()) {
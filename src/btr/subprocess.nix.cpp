@@ -1,5 +1,6 @@
 #include "./subprocess.hpp"
 
+#include "./environ.hpp"
 #include "./pipe.hpp"
 #include "./signal.hpp"
 #include "./syserror.hpp"
@@ -170,9 +171,14 @@ subprocess subprocess::spawn(const subprocess_spawn_options& opts) {
 
     auto error_io_pipe = create_pipe();
 
+    // The child inherits our environment. Don't let a concurrent btr::setenv() leave it
+    // half-modified when we fork.
+    auto env_lock = environ_detail::lock_environment_for_read();
+
     auto child_pid = ::fork();
     if (child_pid != 0) {
         // We are the parent
+        env_lock.unlock();
         error_io_pipe.writer.close();
         throw_if_error_on_pipe(error_io_pipe.reader);
         imp->pid = child_pid;
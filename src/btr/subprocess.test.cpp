@@ -1,5 +1,6 @@
 #include "./subprocess.hpp"
 
+#include <btr/environ.hpp>
 #include <btr/file.hpp>
 #include <btr/signal.hpp>
 
@@ -139,3 +140,13 @@ TEST_CASE("Spawn a simple processs") {
         proc.join();
     }
 }
+
+TEST_CASE("Child processes see modifications to the environment") {
+    if (neo::os_is_unix_like) {
+        btr::setenv("BTR_SPAWN_TEST_VARIABLE", "hello");
+        auto proc = btr::subprocess::spawn(
+            {"/bin/bash", "-c", "test \"$BTR_SPAWN_TEST_VARIABLE\" = hello"});
+        CHECK(proc.join().exit_code == 0);
+        btr::unsetenv("BTR_SPAWN_TEST_VARIABLE");
+    }
+}
@@ -0,0 +1,103 @@
+#include "./u8string.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <ostream>
+
+using namespace btr;
+namespace fs = std::filesystem;
+
+void btr::u8string::_assign_path(const fs::path& path) {
+#if _WIN32
+    assign(path.u8string());
+#else
+    assign(path.native());
+#endif
+}
+
+btr::u8string::u8string(u8string&& other) noexcept { *this = std::move(other); }
+
+u8string& btr::u8string::operator=(u8string&& other) noexcept {
+    if (&other == this) {
+        return *this;
+    }
+    _reset();
+    if (other._is_inline()) {
+        std::memcpy(_inline, other._inline, other._size + 1);
+        _size = other._size;
+    } else {
+        // Steal the allocated buffer
+        _data       = other._data;
+        _size       = other._size;
+        _capacity   = other._capacity;
+        other._data = other._inline;
+    }
+    other._set_size(0);
+    return *this;
+}
+
+void btr::u8string::_reset() noexcept {
+    if (!_is_inline()) {
+        delete[] _data;
+        _data = _inline;
+    }
+    _set_size(0);
+}
+
+void btr::u8string::reserve(std::size_t n) {
+    if (n <= capacity()) {
+        return;
+    }
+    const auto new_cap = (std::max)(n, capacity() * 2);
+    auto       buf     = new char8_t[new_cap + 1];
+    std::memcpy(buf, _data, _size + 1);
+    if (!_is_inline()) {
+        delete[] _data;
+    }
+    _data     = buf;
+    _capacity = new_cap;
+}
+
+void btr::u8string::assign(u8view str) {
+    const auto n = str.size_bytes();
+    if (n > capacity()) {
+        // The given string cannot be a view of our own content, which is smaller
+        clear();
+        reserve(n);
+    }
+    std::memmove(_data, str.u8data(), n);
+    _set_size(n);
+}
+
+void btr::u8string::append(u8view str) {
+    const auto n = str.size_bytes();
+    if (_size + n <= capacity()) {
+        std::memmove(_data + _size, str.u8data(), n);
+        _set_size(_size + n);
+        return;
+    }
+    // Allocate a new buffer before releasing the old one, in case `str` views our own content
+    const auto new_cap = (std::max)(_size + n, capacity() * 2);
+    auto       buf     = new char8_t[new_cap + 1];
+    std::memcpy(buf, _data, _size);
+    std::memcpy(buf + _size, str.u8data(), n);
+    const auto new_size = _size + n;
+    if (!_is_inline()) {
+        delete[] _data;
+    }
+    _data     = buf;
+    _capacity = new_cap;
+    _set_size(new_size);
+}
+
+fs::path btr::u8string::path() const {
+#if _WIN32
+    return fs::path(u8string_view());
+#else
+    return fs::path(string_view());
+#endif
+}
+
+std::ostream& btr::operator<<(std::ostream& out, const u8string& str) {
+    return out << str.string_view();
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "./u8view.hpp"
+
+#include <concepts>
+#include <cstddef>
+#include <filesystem>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
+namespace btr {
+
+/**
+ * @brief An owning UTF-8 string, with room for short strings inline.
+ *
+ * Strings of up to inline_capacity bytes are stored within the object, without allocating. This is
+ * enough for most path elements, environment variable values, and command-line arguments.
+ *
+ * Like u8view, a u8string bridges `char` and `char8_t` strings: it is created from a u8view, and
+ * converts implicitly to a u8view, a std::string, or a std::u8string. The content is always
+ * null-terminated, and is not checked for valid UTF-8.
+ */
+class u8string {
+public:
+    /// The greatest number of bytes that can be held without allocating
+    static constexpr std::size_t inline_capacity = 47;
+
+private:
+    char8_t*    _data = _inline;
+    std::size_t _size = 0;
+    union {
+        /// The capacity of the allocated buffer, excluding the null terminator
+        std::size_t _capacity;
+        char8_t     _inline[inline_capacity + 1] = {};
+    };
+
+    bool _is_inline() const noexcept { return _data == _inline; }
+    void _set_size(std::size_t n) noexcept {
+        _size    = n;
+        _data[n] = 0;
+    }
+    void _reset() noexcept;
+    void _assign_path(const std::filesystem::path& path);
+
+public:
+    /// Create an empty string
+    u8string() noexcept {}
+
+    /// Copy the given string
+    u8string(u8view str) { assign(str); }
+
+    /**
+     * @brief Copy the native representation of the given path.
+     *
+     * On POSIX systems the native representation of a path is copied as-is, without re-encoding.
+     *
+     * (This is a template so that strings are never ambiguously converted to a path.)
+     */
+    template <std::same_as<std::filesystem::path> Path>
+    explicit u8string(const Path& path) {
+        _assign_path(path);
+    }
+
+    u8string(const u8string& other)
+        : u8string(other.u8string_view()) {}
+    u8string(u8string&& other) noexcept;
+
+    u8string& operator=(const u8string& other) {
+        assign(other);
+        return *this;
+    }
+    u8string& operator=(u8string&& other) noexcept;
+
+    ~u8string() { _reset(); }
+
+    /// Replace the content of the string
+    void assign(u8view str);
+    /// Append to the content of the string
+    void append(u8view str);
+    /// Append a single code unit to the string
+    void push_back(char8_t c) { append(u8view{&c, 1}); }
+
+    u8string& operator+=(u8view str) {
+        append(str);
+        return *this;
+    }
+
+    /// Ensure that the string has room for at least `n` bytes without further allocations
+    void reserve(std::size_t n);
+    /// Remove the content of the string, retaining the storage
+    void clear() noexcept { _set_size(0); }
+
+    /// The number of bytes in the string
+    [[nodiscard]] std::size_t size() const noexcept { return _size; }
+    /// Whether the string is empty
+    [[nodiscard]] bool empty() const noexcept { return _size == 0; }
+    /// The number of bytes that the string can hold without allocating
+    [[nodiscard]] std::size_t capacity() const noexcept {
+        return _is_inline() ? inline_capacity : _capacity;
+    }
+
+    /// Get a pointer to the char8_t data
+    [[nodiscard]] const char8_t* u8data() const noexcept { return _data; }
+    /// Get a pointer to the null-terminated string as char data, e.g. for passing to system APIs
+    [[nodiscard]] const char* c_str() const noexcept {
+        return reinterpret_cast<const char*>(_data);
+    }
+
+    const char8_t* begin() const noexcept { return _data; }
+    const char8_t* end() const noexcept { return _data + _size; }
+
+    /// Return as a std::u8string_view
+    [[nodiscard]] std::u8string_view u8string_view() const noexcept { return {_data, _size}; }
+    /// Return as a std::string_view
+    [[nodiscard]] std::string_view string_view() const noexcept { return {c_str(), _size}; }
+
+    /**
+     * @brief Create a path from the string.
+     *
+     * On POSIX systems the string is used as the native representation of the path, without
+     * re-encoding.
+     */
+    [[nodiscard]] std::filesystem::path path() const;
+
+    operator u8view() const noexcept { return u8view{_data, _size}; }
+    operator std::string() const { return std::string{string_view()}; }
+    operator std::u8string() const { return std::u8string{u8string_view()}; }
+
+    /// Check whether the string begins with the given prefix
+    [[nodiscard]] bool starts_with(u8view prefix) const noexcept {
+        return u8string_view().starts_with(prefix.u8string_view());
+    }
+    /// Check whether the string ends with the given suffix
+    [[nodiscard]] bool ends_with(u8view suffix) const noexcept {
+        return u8string_view().ends_with(suffix.u8string_view());
+    }
+
+    friend bool operator==(const u8string& lhs, const u8string& rhs) noexcept {
+        return lhs.u8string_view() == rhs.u8string_view();
+    }
+    friend bool operator==(const u8string& lhs, u8view rhs) noexcept {
+        return lhs.u8string_view() == rhs.u8string_view();
+    }
+    friend auto operator<=>(const u8string& lhs, const u8string& rhs) noexcept {
+        return lhs.u8string_view() <=> rhs.u8string_view();
+    }
+
+    friend std::ostream& operator<<(std::ostream& out, const u8string& str);
+};
+
+std::ostream& operator<<(std::ostream& out, const u8string& str);
+
+}  // namespace btr
+
+template <>
+struct std::hash<btr::u8string> {
+    std::size_t operator()(const btr::u8string& str) const noexcept {
+        return std::hash<std::u8string_view>{}(str.u8string_view());
+    }
+};
@@ -0,0 +1,82 @@
+#include "./u8string.hpp"
+
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <unordered_set>
+
+using namespace std::literals;
+
+TEST_CASE("Short strings are stored inline") {
+    btr::u8string str;
+    CHECK(str.empty());
+    CHECK(str.c_str() == ""sv);
+
+    str = btr::u8view("Hello");
+    CHECK(str.size() == 5);
+    CHECK(str.capacity() == btr::u8string::inline_capacity);
+    CHECK(str == "Hello");
+
+    str.assign(std::string(btr::u8string::inline_capacity, 'a'));
+    CHECK(str.capacity() == btr::u8string::inline_capacity);
+
+    str.push_back('b');
+    CHECK(str.size() == btr::u8string::inline_capacity + 1);
+    CHECK(str.capacity() > btr::u8string::inline_capacity);
+    CHECK(str.ends_with("ab"));
+    CHECK(str.c_str()[str.size()] == 0);
+}
+
+TEST_CASE("Copy and move strings") {
+    auto short_str = "short"s;
+    auto long_str  = std::string(200, 'x');
+    for (auto orig : {short_str, long_str}) {
+        btr::u8string str{orig};
+        btr::u8string copy{str};
+        CHECK(copy == str);
+        CHECK(copy.u8data() != str.u8data());
+
+        btr::u8string moved{std::move(str)};
+        CHECK(moved == orig);
+        CHECK(str.empty());
+
+        str = std::move(moved);
+        CHECK(str == orig);
+        copy = str;
+        CHECK(copy == orig);
+    }
+}
+
+TEST_CASE("Append a string to itself") {
+    btr::u8string str{"abc"};
+    str += str;
+    CHECK(str == "abcabc");
+    while (str.size() <= btr::u8string::inline_capacity) {
+        // Eventually requires a reallocation while appending from the old buffer
+        str.append(str);
+    }
+    CHECK(str.size() == 48);
+    CHECK(str.starts_with("abcabc"));
+
+    // Assign from a view of a substring of itself
+    str.assign(btr::u8view(str.u8string_view().substr(3, 6)));
+    CHECK(str == "abcabc");
+}
+
+TEST_CASE("Convert to and from other string types") {
+    btr::u8string str{u8"café"};
+    std::string   s = str;
+    CHECK(s == "caf\xc3\xa9");
+    std::u8string u8 = str;
+    CHECK(u8 == u8"café");
+    btr::u8view view = str;
+    CHECK(view.u8string_view() == u8"café");
+
+    auto path = str.path();
+    CHECK(path.filename().u8string() == u8"café");
+    CHECK(btr::u8string{path} == str);
+
+    std::unordered_set<btr::u8string> set;
+    set.insert(str);
+    CHECK(set.contains(btr::u8string{"caf\xc3\xa9"}));
+}
@@ -0,0 +1,242 @@
+#include "./unicode.hpp"
+
+#include <algorithm>
+
+using namespace btr;
+using namespace btr::unicode_detail;
+
+namespace {
+
+// Constants for the algorithmic (de)composition of Hangul syllables. See §3.12 of the Unicode
+// standard.
+constexpr char32_t    s_base  = 0xAC00;
+constexpr char32_t    l_base  = 0x1100;
+constexpr char32_t    v_base  = 0x1161;
+constexpr char32_t    t_base  = 0x11A7;
+constexpr std::size_t l_count = 19;
+constexpr std::size_t v_count = 21;
+constexpr std::size_t t_count = 28;
+constexpr std::size_t n_count = v_count * t_count;
+constexpr std::size_t s_count = l_count * n_count;
+
+enum class quick_check { yes, maybe, no };
+
+struct quick_check_result {
+    quick_check result;
+    /**
+     * The length of the prefix of the string that is known to be unaffected by normalization.
+     * This prefix ends before a starter, so normalization of the remainder of the string cannot
+     * interact with it.
+     */
+    std::size_t stable_prefix;
+};
+
+/**
+ * Perform the quick-check algorithm of UAX #15 on the given string. Invalid UTF-8 is reported as
+ * not normalized.
+ */
+quick_check_result do_quick_check(std::u8string_view str, normal_form form) noexcept {
+    const std::uint8_t no_flag    = form == normal_form::nfc ? nfc_qc_no : nfd_qc_no;
+    const std::uint8_t maybe_flag = form == normal_form::nfc ? nfc_qc_maybe : 0;
+
+    auto                 result        = quick_check::yes;
+    std::size_t          stable_prefix = 0;
+    std::uint8_t         last_ccc      = 0;
+    const char8_t*       ptr           = str.data();
+    const char8_t* const stop          = ptr + str.size();
+    while (ptr != stop) {
+        if (*ptr < 0x80) {
+            // A run of ASCII is always normalized, and every ASCII character is a starter
+            const auto n_ascii
+                = utf_detail::ascii_prefix_length(ptr, static_cast<std::size_t>(stop - ptr));
+            ptr += n_ascii;
+            last_ccc = 0;
+            if (result == quick_check::yes) {
+                // The last ASCII character is a starter that may be affected by what follows
+                stable_prefix = static_cast<std::size_t>(ptr - str.data()) - 1;
+            }
+            continue;
+        }
+        auto res = utf_detail::ll_try_decode(ptr, stop);
+        if (!res.valid) {
+            return {quick_check::no, stable_prefix};
+        }
+        const auto props = get_norm_props(res.codepoint);
+        if (props.ccc != 0 && last_ccc > props.ccc) {
+            return {quick_check::no, stable_prefix};
+        }
+        if (props.flags & no_flag) {
+            return {quick_check::no, stable_prefix};
+        }
+        if (props.flags & maybe_flag) {
+            result = quick_check::maybe;
+        } else if (props.ccc == 0 && result == quick_check::yes) {
+            stable_prefix = static_cast<std::size_t>(ptr - str.data());
+        }
+        last_ccc = props.ccc;
+        ptr += res.n_cus_taken;
+    }
+    return {result, stable_prefix};
+}
+
+std::uint8_t combining_class(char32_t c) noexcept { return get_norm_props(c).ccc; }
+
+/// Append the full canonical decomposition of `c` to `out`
+void decompose_into(char32_t c, std::u32string& out) {
+    if (c >= s_base && c < s_base + s_count) {
+        const auto s_index = c - s_base;
+        out.push_back(static_cast<char32_t>(l_base + s_index / n_count));
+        out.push_back(static_cast<char32_t>(v_base + (s_index % n_count) / t_count));
+        if (s_index % t_count != 0) {
+            out.push_back(static_cast<char32_t>(t_base + s_index % t_count));
+        }
+        return;
+    }
+    char32_t   parts[2];
+    const auto n_parts = canonical_decomposition(c, parts);
+    if (n_parts == 0) {
+        out.push_back(c);
+        return;
+    }
+    for (auto part : std::span{parts, n_parts}) {
+        decompose_into(part, out);
+    }
+}
+
+/// Apply the canonical ordering algorithm: Stable-sort each run of non-starters by their ccc
+void canonical_order(std::u32string& cps) {
+    auto it = cps.begin();
+    while (it != cps.end()) {
+        auto run_end = std::find_if(it, cps.end(), [](char32_t c) {
+            return combining_class(c) == 0;
+        });
+        if (run_end - it > 1) {
+            std::stable_sort(it, run_end, [](char32_t a, char32_t b) {
+                return combining_class(a) < combining_class(b);
+            });
+        }
+        if (run_end == cps.end()) {
+            break;
+        }
+        it = std::next(run_end);
+    }
+}
+
+/// Get the primary composite of the given pair, or zero
+char32_t compose_pair(char32_t first, char32_t second) noexcept {
+    if (first >= l_base && first < l_base + l_count && second >= v_base
+        && second < v_base + v_count) {
+        const auto lv_index = (first - l_base) * n_count + (second - v_base) * t_count;
+        return static_cast<char32_t>(s_base + lv_index);
+    }
+    if (first >= s_base && first < s_base + s_count && (first - s_base) % t_count == 0
+        && second > t_base && second < t_base + t_count) {
+        return static_cast<char32_t>(first + (second - t_base));
+    }
+    return canonical_composition(first, second);
+}
+
+/// Apply the canonical composition algorithm to a canonically decomposed string
+void canonical_compose(std::u32string& cps) {
+    if (cps.empty()) {
+        return;
+    }
+    std::size_t starter_pos = 0;
+    // The ccc of the last codepoint that was not combined. A non-starter at the beginning of the
+    // string is given an impossible class, so that nothing combines with it.
+    int         last_ccc    = combining_class(cps[0]) == 0 ? 0 : 256;
+    std::size_t out_pos     = 1;
+    for (std::size_t pos = 1; pos < cps.size(); ++pos) {
+        const auto c   = cps[pos];
+        const int  ccc = combining_class(c);
+        // A codepoint may combine with the starter if no codepoint between them is blocking
+        const bool blocked = last_ccc != 0 && last_ccc >= ccc;
+        if (!blocked) {
+            const auto composite = compose_pair(cps[starter_pos], c);
+            if (composite != 0) {
+                cps[starter_pos] = composite;
+                continue;
+            }
+        }
+        if (ccc == 0) {
+            starter_pos = out_pos;
+        }
+        last_ccc       = ccc;
+        cps[out_pos++] = c;
+    }
+    cps.resize(out_pos);
+}
+
+}  // namespace
+
+bool btr::is_normalized(std::u8string_view str, normal_form form) {
+    const auto qc = do_quick_check(str, form);
+    if (qc.result != quick_check::maybe) {
+        return qc.result == quick_check::yes;
+    }
+    std::u8string buffer;
+    return normalize(str, form, buffer) == str;
+}
+
+std::u8string btr::normalize(std::u8string_view str, normal_form form) {
+    std::u8string buffer;
+    auto          result = normalize(str, form, buffer);
+    if (result.data() != buffer.data()) {
+        buffer.assign(result);
+    }
+    return buffer;
+}
+
+std::u8string_view btr::normalize(std::u8string_view str, normal_form form, std::u8string& buffer) {
+    const auto qc = do_quick_check(str, form);
+    if (qc.result == quick_check::yes) {
+        return str;
+    }
+
+    // Decompose everything following the stable prefix, replacing invalid input with U+FFFD
+    std::u32string cps;
+    cps.reserve(str.size() - qc.stable_prefix);
+    const char8_t*       ptr  = str.data() + qc.stable_prefix;
+    const char8_t* const stop = str.data() + str.size();
+    while (ptr != stop) {
+        auto res = utf_detail::ll_try_decode(ptr, stop);
+        decompose_into(res.codepoint, cps);
+        ptr += res.n_cus_taken;
+    }
+    canonical_order(cps);
+    if (form == normal_form::nfc) {
+        canonical_compose(cps);
+    }
+
+    // A "maybe" from the quick check is often already normalized. If so, return the input and
+    // leave the buffer alone, as when the quick check says "yes".
+    auto tail = str.substr(qc.stable_prefix);
+    bool same = true;
+    for (auto c : cps) {
+        const auto enc = utf_detail::ll_encode(c, neo::tag<char8_t>{});
+        if (!tail.starts_with(std::u8string_view(enc.units, enc.count))) {
+            same = false;
+            break;
+        }
+        tail.remove_prefix(enc.count);
+    }
+    if (same && tail.empty()) {
+        return str;
+    }
+
+    buffer.assign(str.substr(0, qc.stable_prefix));
+    for (auto c : cps) {
+        const auto enc = utf_detail::ll_encode(c, neo::tag<char8_t>{});
+        buffer.append(enc.units, enc.count);
+    }
+    return buffer;
+}
+
+bool btr::canonically_equivalent(std::u8string_view a, std::u8string_view b) {
+    if (a == b) {
+        return true;
+    }
+    std::u8string a_buf;
+    std::u8string b_buf;
+    return normalize(a, normal_form::nfd, a_buf) == normalize(b, normal_form::nfd, b_buf);
+}
@@ -0,0 +1,265 @@
+#pragma once
+
+#include "./utf.hpp"
+
+#include <neo/iterator_facade.hpp>
+
+#include <cstdint>
+#include <ranges>
+#include <string>
+#include <string_view>
+
+namespace btr {
+
+namespace unicode_detail {
+
+/// Quick-check property flags for normalization, stored in norm_props::flags
+enum norm_flags : std::uint8_t {
+    /// The codepoint cannot appear in NFD text
+    nfd_qc_no = 1,
+    /// The codepoint may combine with a preceding codepoint when composed to NFC
+    nfc_qc_maybe = 2,
+    /// The codepoint cannot appear in NFC text
+    nfc_qc_no = 4,
+};
+
+/// The normalization properties of a codepoint
+struct norm_props {
+    /// The Canonical_Combining_Class of the codepoint
+    std::uint8_t ccc = 0;
+    /// The quick-check flags of the codepoint (see norm_flags)
+    std::uint8_t flags = 0;
+};
+
+/// Values of the Grapheme_Cluster_Break property (UAX #29)
+enum class grapheme_break : std::uint8_t {
+    other,
+    cr,
+    lf,
+    control,
+    extend,
+    zwj,
+    regional_indicator,
+    prepend,
+    spacing_mark,
+    l,
+    v,
+    t,
+    lv,
+    lvt,
+    extended_pictographic,
+};
+
+/// Get the normalization properties of a codepoint
+norm_props get_norm_props(char32_t c) noexcept;
+
+/// Get the Grapheme_Cluster_Break property of a codepoint, with Extended_Pictographic folded in
+grapheme_break get_grapheme_break(char32_t c) noexcept;
+
+/**
+ * @brief Get the single-level canonical decomposition of a codepoint.
+ *
+ * Hangul syllables are not included, as they are decomposed algorithmically.
+ *
+ * @param c The codepoint to decompose
+ * @param out Receives up to two codepoints
+ * @return std::size_t The number of codepoints written, or zero if `c` has no decomposition.
+ */
+std::size_t canonical_decomposition(char32_t c, char32_t* out) noexcept;
+
+/**
+ * @brief Get the primary composite of the given pair of codepoints, or zero if there is none.
+ *
+ * Hangul syllables are not included, as they are composed algorithmically.
+ */
+char32_t canonical_composition(char32_t first, char32_t second) noexcept;
+
+/**
+ * @brief Tracks the context of a grapheme cluster while it is being scanned, as required by the
+ * segmentation rules of UAX #29.
+ */
+class grapheme_segmenter {
+    grapheme_break _prev;
+    /// Whether we have seen Extended_Pictographic Extend*
+    bool _emoji = false;
+    /// Whether we have seen Extended_Pictographic Extend* ZWJ
+    bool _emoji_zwj = false;
+    /// Whether the cluster ends with an odd number of Regional_Indicator codepoints
+    bool _odd_ri = false;
+
+public:
+    explicit grapheme_segmenter(grapheme_break first) noexcept
+        : _prev(first)
+        , _emoji(first == grapheme_break::extended_pictographic)
+        , _odd_ri(first == grapheme_break::regional_indicator) {}
+
+    /**
+     * @brief Determine whether there is a cluster boundary before a codepoint with the given
+     * property. If there is not, the codepoint is added to the current cluster.
+     */
+    bool is_boundary_before(grapheme_break next) noexcept {
+        using gb = grapheme_break;
+        bool boundary = true;
+        if (_prev == gb::cr && next == gb::lf) {
+            boundary = false;  // GB3
+        } else if (_prev == gb::cr || _prev == gb::lf || _prev == gb::control) {
+            boundary = true;  // GB4
+        } else if (next == gb::cr || next == gb::lf || next == gb::control) {
+            boundary = true;  // GB5
+        } else if (_prev == gb::l
+                   && (next == gb::l || next == gb::v || next == gb::lv || next == gb::lvt)) {
+            boundary = false;  // GB6
+        } else if ((_prev == gb::lv || _prev == gb::v) && (next == gb::v || next == gb::t)) {
+            boundary = false;  // GB7
+        } else if ((_prev == gb::lvt || _prev == gb::t) && next == gb::t) {
+            boundary = false;  // GB8
+        } else if (next == gb::extend || next == gb::zwj || next == gb::spacing_mark) {
+            boundary = false;  // GB9, GB9a
+        } else if (_prev == gb::prepend) {
+            boundary = false;  // GB9b
+        } else if (_emoji_zwj && next == gb::extended_pictographic) {
+            boundary = false;  // GB11
+        } else if (_odd_ri && next == gb::regional_indicator) {
+            boundary = false;  // GB12, GB13
+        }
+        if (boundary) {
+            *this = grapheme_segmenter{next};
+            return true;
+        }
+        _emoji_zwj = _emoji && next == gb::zwj;
+        _emoji     = next == gb::extended_pictographic || (_emoji && next == gb::extend);
+        _odd_ri    = next == gb::regional_indicator && !_odd_ri;
+        _prev      = next;
+        return false;
+    }
+};
+
+/**
+ * @brief Find the end of the extended grapheme cluster that begins at `it`.
+ *
+ * @param it An iterator of codepoints. Must not be equal to `stop`.
+ * @param stop The end of the codepoints
+ */
+template <std::forward_iterator Iter, std::sentinel_for<Iter> Stop>
+Iter next_grapheme_boundary(Iter it, const Stop stop) noexcept {
+    grapheme_segmenter seg{get_grapheme_break(*it)};
+    for (++it; it != stop; ++it) {
+        if (seg.is_boundary_before(get_grapheme_break(*it))) {
+            break;
+        }
+    }
+    return it;
+}
+
+}  // namespace unicode_detail
+
+/**
+ * @brief A Unicode normalization form
+ */
+enum class normal_form {
+    /// Normalization Form C: Canonical decomposition, followed by canonical composition
+    nfc,
+    /// Normalization Form D: Canonical decomposition
+    nfd,
+};
+
+/**
+ * @brief Determine whether the given UTF-8 string is in the given normalization form.
+ *
+ * Most strings are checked with a single pass over the string without allocating. Invalid UTF-8
+ * is never normalized.
+ */
+[[nodiscard]] bool is_normalized(std::u8string_view str, normal_form form);
+
+/**
+ * @brief Convert a UTF-8 string to the given normalization form.
+ *
+ * Invalid code unit sequences are replaced with U+FFFD REPLACEMENT CHARACTER.
+ */
+[[nodiscard]] std::u8string normalize(std::u8string_view str, normal_form form);
+
+/**
+ * @brief Convert a UTF-8 string to the given normalization form, using `buffer` for storage if
+ * required.
+ *
+ * If the string is already normalized, it is returned unchanged and `buffer` is not modified.
+ * Otherwise, the normalized string is written into `buffer`, and the return value views `buffer`.
+ * This allows normalizing many strings without allocating in the common case that they are already
+ * normalized.
+ */
+[[nodiscard]] std::u8string_view
+normalize(std::u8string_view str, normal_form form, std::u8string& buffer);
+
+/**
+ * @brief Determine whether two UTF-8 strings are canonically equivalent, i.e. whether they are
+ * equal after normalization.
+ *
+ * This allows text that was composed differently (e.g. a filename received from a macOS system in
+ * NFD, and a filename received from a Linux system in NFC) to compare equal.
+ */
+[[nodiscard]] bool canonically_equivalent(std::u8string_view a, std::u8string_view b);
+
+/**
+ * @brief A forward view of the extended grapheme clusters in a contiguous Unicode string.
+ *
+ * Each element is a basic_string_view of the code units of one user-perceived character, as
+ * segmented by the default rules of UAX #29. Invalid code unit sequences are treated as U+FFFD, as
+ * with codepoint_view.
+ *
+ * @tparam Char The code unit type of the string
+ */
+template <utf_detail::code_unit Char>
+class grapheme_view : public std::ranges::view_interface<grapheme_view<Char>> {
+    codepoint_view<Char> _codepoints;
+
+    using cp_iterator = typename codepoint_view<Char>::iterator;
+
+public:
+    grapheme_view() = default;
+    explicit grapheme_view(std::basic_string_view<Char> str) noexcept
+        : _codepoints(str) {}
+
+    class iterator : public neo::iterator_facade<iterator> {
+        cp_iterator _pos;
+        cp_iterator _next;
+        cp_iterator _stop;
+
+    public:
+        iterator() = default;
+        iterator(cp_iterator pos, cp_iterator stop) noexcept
+            : _pos(pos)
+            , _next(pos)
+            , _stop(stop) {
+            if (_pos != _stop) {
+                _next = unicode_detail::next_grapheme_boundary(_pos, _stop);
+            }
+        }
+
+        std::basic_string_view<Char> dereference() const noexcept {
+            return {_pos.base(), static_cast<std::size_t>(_next.base() - _pos.base())};
+        }
+
+        void increment() noexcept {
+            _pos = _next;
+            if (_pos != _stop) {
+                _next = unicode_detail::next_grapheme_boundary(_pos, _stop);
+            }
+        }
+
+        bool operator==(const iterator& o) const noexcept { return _pos == o._pos; }
+
+        /// Get the offset of the current cluster from the beginning of the string, in code units
+        std::size_t offset() const noexcept { return _pos.offset(); }
+    };
+
+    iterator begin() const noexcept { return iterator{_codepoints.begin(), _codepoints.end()}; }
+    iterator end() const noexcept { return iterator{_codepoints.end(), _codepoints.end()}; }
+
+    /// Obtain the underlying string
+    std::basic_string_view<Char> str() const noexcept { return _codepoints.str(); }
+};
+
+template <typename Char>
+grapheme_view(std::basic_string_view<Char>) -> grapheme_view<Char>;
+
+}  // namespace btr
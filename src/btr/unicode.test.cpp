@@ -0,0 +1,107 @@
+#include <btr/unicode.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std::literals;
+
+TEST_CASE("Normalize strings") {
+    struct case_ {
+        std::u8string_view input;
+        std::u8string_view nfc;
+        std::u8string_view nfd;
+    };
+
+    auto [input, nfc, nfd] = GENERATE(Catch::Generators::values<case_>({
+        {u8"", u8"", u8""},
+        {u8"plain ascii", u8"plain ascii", u8"plain ascii"},
+        // Precomposed and decomposed 'é'
+        {u8"café", u8"café", u8"cafe\u0301"},
+        {u8"cafe\u0301", u8"café", u8"cafe\u0301"},
+        // Combining marks are reordered by their combining class
+        {u8"a\u0301\u0323", u8"ạ\u0301", u8"a\u0323\u0301"},
+        {u8"ḋ\u0323", u8"ḍ\u0307", u8"d\u0323\u0307"},
+        // Singletons and composition exclusions never appear in NFC
+        {u8"Å", u8"Å", u8"A\u030a"},
+        {u8"क़", u8"क\u093c", u8"क\u093c"},
+        // Hangul syllables are (de)composed algorithmically
+        {u8"한", u8"한", u8"\u1112\u1161\u11ab"},
+        {u8"\u1112\u1161\u11ab\u1100", u8"한\u1100", u8"\u1112\u1161\u11ab\u1100"},
+        // A leading combining mark does not combine with anything
+        {u8"\u0301e", u8"\u0301e", u8"\u0301e"},
+    }));
+
+    INFO("Input: " << std::string(input.begin(), input.end()));
+    CHECK(btr::normalize(input, btr::normal_form::nfc) == nfc);
+    CHECK(btr::normalize(input, btr::normal_form::nfd) == nfd);
+    CHECK(btr::is_normalized(nfc, btr::normal_form::nfc));
+    CHECK(btr::is_normalized(nfd, btr::normal_form::nfd));
+    CHECK(btr::is_normalized(input, btr::normal_form::nfc) == (input == nfc));
+    CHECK(btr::is_normalized(input, btr::normal_form::nfd) == (input == nfd));
+    CHECK(btr::canonically_equivalent(nfc, nfd));
+}
+
+TEST_CASE("Normalized strings are not copied") {
+    std::u8string buffer;
+    auto          str = u8"Naïve café"sv;
+    auto          res = btr::normalize(str, btr::normal_form::nfc, buffer);
+    CHECK(res.data() == str.data());
+    CHECK(buffer.empty());
+
+    str = u8"Nai\u0308ve cafe\u0301";
+    res = btr::normalize(str, btr::normal_form::nfc, buffer);
+    CHECK(res.data() == buffer.data());
+    CHECK(res == u8"Naïve café");
+
+    // U+0301 may compose with what precedes it, but there is no precomposed x-acute, so the string
+    // is already normalized even though the quick check cannot tell
+    buffer.clear();
+    str = u8"x\u0301";
+    res = btr::normalize(str, btr::normal_form::nfc, buffer);
+    CHECK(res.data() == str.data());
+    CHECK(buffer.empty());
+
+    // Invalid UTF-8 is replaced
+    CHECK(btr::normalize(u8"a\xffz", btr::normal_form::nfc) == u8"a�z");
+    CHECK_FALSE(btr::is_normalized(u8"a\xffz", btr::normal_form::nfd));
+
+    CHECK_FALSE(btr::canonically_equivalent(u8"cafe", u8"café"));
+}
+
+TEST_CASE("Segment grapheme clusters") {
+    struct case_ {
+        std::u8string_view              input;
+        std::vector<std::u8string_view> expect;
+    };
+
+    auto [input, expect] = GENERATE(Catch::Generators::values<case_>({
+        {u8"", {}},
+        {u8"abc", {u8"a", u8"b", u8"c"}},
+        {u8"a\r\nb\n\r", {u8"a", u8"\r\n", u8"b", u8"\n", u8"\r"}},
+        {u8"cafe\u0301!", {u8"c", u8"a", u8"f", u8"e\u0301", u8"!"}},
+        // Hangul syllable sequences
+        {u8"\u1112\u1161\u11ab한", {u8"\u1112\u1161\u11ab", u8"한"}},
+        // Regional indicators pair up into flags
+        {u8"\U0001f1fa\U0001f1f8\U0001f1eb\U0001f1f7\U0001f1e9",
+         {u8"\U0001f1fa\U0001f1f8", u8"\U0001f1eb\U0001f1f7", u8"\U0001f1e9"}},
+        // An emoji ZWJ sequence, and an emoji with a skin tone modifier
+        {u8"\U0001f468\u200d\U0001f469\u200d\U0001f467x\U0001f44d\U0001f3fd",
+         {u8"\U0001f468\u200d\U0001f469\u200d\U0001f467", u8"x", u8"\U0001f44d\U0001f3fd"}},
+        // A ZWJ only joins pictographs
+        {u8"a\u200d\U0001f468", {u8"a\u200d", u8"\U0001f468"}},
+        // Spacing marks and prepended characters
+        {u8"क\u093f\u0600a", {u8"क\u093f", u8"\u0600a"}},
+        // Invalid UTF-8 is segmented as U+FFFD
+        {u8"a\xff\u0301", {u8"a", u8"\xff\u0301"}},
+    }));
+
+    INFO("Input: " << std::string(input.begin(), input.end()));
+    std::vector<std::u8string_view> clusters;
+    for (auto cluster : btr::grapheme_view{input}) {
+        clusters.push_back(cluster);
+    }
+    CHECK(clusters == expect);
+}
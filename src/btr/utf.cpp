@@ -3,9 +3,283 @@
 #include <neo/utf8.hpp>
 #include <neo/utility.hpp>
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BTR_UTF_SSE2 1
+#include <emmintrin.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+// AVX2 kernels are compiled for a specific target, and are only used if the processor supports
+// them at runtime
+#define BTR_UTF_AVX2 1
+#include <immintrin.h>
+#endif
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define BTR_UTF_NEON 1
+#include <arm_neon.h>
+#endif
+
 using namespace btr;
 using std::span;
 
+namespace {
+
+/// Implementation of ascii_prefix_length() that uses only the baseline instruction set
+std::size_t ascii_prefix_baseline(const char8_t* const ptr, std::size_t len) noexcept {
+    std::size_t off = 0;
+#if BTR_UTF_SSE2
+    for (; off + 16 <= len; off += 16) {
+        auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + off));
+        // The sign bit of each byte is set for non-ASCII code units
+        if (_mm_movemask_epi8(chunk) != 0) {
+            break;
+        }
+    }
+#elif BTR_UTF_NEON
+    for (; off + 16 <= len; off += 16) {
+        if (vmaxvq_u8(vld1q_u8(reinterpret_cast<const std::uint8_t*>(ptr + off))) >= 0x80) {
+            break;
+        }
+    }
+#endif
+    for (; off + 8 <= len; off += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, ptr + off, sizeof word);
+        if (word & 0x8080'8080'8080'8080u) {
+            break;
+        }
+    }
+    while (off < len && ptr[off] < 0x80) {
+        ++off;
+    }
+    return off;
+}
+
+/*
+ * The ASCII kernels below convert whole blocks of ASCII code units between code unit widths. Each
+ * returns the number of code units that were converted, stopping before the first block that
+ * contains a non-ASCII code unit, or that extends beyond the end of the input. The output is
+ * written using vector stores only, so it is given as an untyped pointer.
+ */
+
+#if BTR_UTF_SSE2
+std::size_t widen16_sse2(const char8_t* in, std::size_t len, void* out_) noexcept {
+    auto        out  = static_cast<char*>(out_);
+    const auto  zero = _mm_setzero_si128();
+    std::size_t off  = 0;
+    for (; off + 16 <= len; off += 16) {
+        auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + off));
+        if (_mm_movemask_epi8(chunk) != 0) {
+            break;
+        }
+        auto dest = reinterpret_cast<__m128i*>(out + off * 2);
+        _mm_storeu_si128(dest, _mm_unpacklo_epi8(chunk, zero));
+        _mm_storeu_si128(dest + 1, _mm_unpackhi_epi8(chunk, zero));
+    }
+    return off;
+}
+
+std::size_t widen32_sse2(const char8_t* in, std::size_t len, void* out_) noexcept {
+    auto        out  = static_cast<char*>(out_);
+    const auto  zero = _mm_setzero_si128();
+    std::size_t off  = 0;
+    for (; off + 16 <= len; off += 16) {
+        auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + off));
+        if (_mm_movemask_epi8(chunk) != 0) {
+            break;
+        }
+        auto lo   = _mm_unpacklo_epi8(chunk, zero);
+        auto hi   = _mm_unpackhi_epi8(chunk, zero);
+        auto dest = reinterpret_cast<__m128i*>(out + off * 4);
+        _mm_storeu_si128(dest, _mm_unpacklo_epi16(lo, zero));
+        _mm_storeu_si128(dest + 1, _mm_unpackhi_epi16(lo, zero));
+        _mm_storeu_si128(dest + 2, _mm_unpacklo_epi16(hi, zero));
+        _mm_storeu_si128(dest + 3, _mm_unpackhi_epi16(hi, zero));
+    }
+    return off;
+}
+
+std::size_t narrow16_sse2(const char16_t* in, std::size_t len, void* out) noexcept {
+    const auto  non_ascii = _mm_set1_epi16(static_cast<short>(0xff80));
+    const auto  zero      = _mm_setzero_si128();
+    std::size_t off       = 0;
+    for (; off + 16 <= len; off += 16) {
+        auto a     = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + off));
+        auto b     = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + off + 8));
+        auto high  = _mm_and_si128(_mm_or_si128(a, b), non_ascii);
+        auto clear = _mm_cmpeq_epi16(high, zero);
+        if (_mm_movemask_epi8(clear) != 0xffff) {
+            break;
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(static_cast<char*>(out) + off),
+                         _mm_packus_epi16(a, b));
+    }
+    return off;
+}
+#elif BTR_UTF_NEON
+std::size_t widen16_neon(const char8_t* in, std::size_t len, void* out_) noexcept {
+    auto        out = static_cast<std::uint16_t*>(out_);
+    std::size_t off = 0;
+    for (; off + 16 <= len; off += 16) {
+        auto chunk = vld1q_u8(reinterpret_cast<const std::uint8_t*>(in + off));
+        if (vmaxvq_u8(chunk) >= 0x80) {
+            break;
+        }
+        vst1q_u16(out + off, vmovl_u8(vget_low_u8(chunk)));
+        vst1q_u16(out + off + 8, vmovl_u8(vget_high_u8(chunk)));
+    }
+    return off;
+}
+
+std::size_t widen32_neon(const char8_t* in, std::size_t len, void* out_) noexcept {
+    auto        out = static_cast<std::uint32_t*>(out_);
+    std::size_t off = 0;
+    for (; off + 16 <= len; off += 16) {
+        auto chunk = vld1q_u8(reinterpret_cast<const std::uint8_t*>(in + off));
+        if (vmaxvq_u8(chunk) >= 0x80) {
+            break;
+        }
+        auto lo = vmovl_u8(vget_low_u8(chunk));
+        auto hi = vmovl_u8(vget_high_u8(chunk));
+        vst1q_u32(out + off, vmovl_u16(vget_low_u16(lo)));
+        vst1q_u32(out + off + 4, vmovl_u16(vget_high_u16(lo)));
+        vst1q_u32(out + off + 8, vmovl_u16(vget_low_u16(hi)));
+        vst1q_u32(out + off + 12, vmovl_u16(vget_high_u16(hi)));
+    }
+    return off;
+}
+
+std::size_t narrow16_neon(const char16_t* in, std::size_t len, void* out_) noexcept {
+    auto        out = static_cast<std::uint8_t*>(out_);
+    std::size_t off = 0;
+    for (; off + 16 <= len; off += 16) {
+        auto a = vld1q_u16(reinterpret_cast<const std::uint16_t*>(in + off));
+        auto b = vld1q_u16(reinterpret_cast<const std::uint16_t*>(in + off + 8));
+        if (vmaxvq_u16(vorrq_u16(a, b)) >= 0x80) {
+            break;
+        }
+        vst1q_u8(out + off, vcombine_u8(vmovn_u16(a), vmovn_u16(b)));
+    }
+    return off;
+}
+#endif
+
+#if BTR_UTF_AVX2
+[[gnu::target("avx2")]] std::size_t
+ascii_prefix_avx2(const char8_t* ptr, std::size_t len) noexcept {
+    std::size_t off = 0;
+    for (; off + 32 <= len; off += 32) {
+        auto chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr + off));
+        if (_mm256_movemask_epi8(chunk) != 0) {
+            break;
+        }
+    }
+    return off + ascii_prefix_baseline(ptr + off, len - off);
+}
+
+[[gnu::target("avx2")]] std::size_t
+widen16_avx2(const char8_t* in, std::size_t len, void* out_) noexcept {
+    auto        out = static_cast<char*>(out_);
+    std::size_t off = 0;
+    for (; off + 32 <= len; off += 32) {
+        auto chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + off));
+        if (_mm256_movemask_epi8(chunk) != 0) {
+            break;
+        }
+        auto dest = reinterpret_cast<__m256i*>(out + off * 2);
+        _mm256_storeu_si256(dest, _mm256_cvtepu8_epi16(_mm256_castsi256_si128(chunk)));
+        _mm256_storeu_si256(dest + 1, _mm256_cvtepu8_epi16(_mm256_extracti128_si256(chunk, 1)));
+    }
+    return off;
+}
+
+[[gnu::target("avx2")]] std::size_t
+widen32_avx2(const char8_t* in, std::size_t len, void* out_) noexcept {
+    auto        out = static_cast<char*>(out_);
+    std::size_t off = 0;
+    for (; off + 32 <= len; off += 32) {
+        auto chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + off));
+        if (_mm256_movemask_epi8(chunk) != 0) {
+            break;
+        }
+        auto lo   = _mm256_castsi256_si128(chunk);
+        auto hi   = _mm256_extracti128_si256(chunk, 1);
+        auto dest = reinterpret_cast<__m256i*>(out + off * 4);
+        _mm256_storeu_si256(dest, _mm256_cvtepu8_epi32(lo));
+        _mm256_storeu_si256(dest + 1, _mm256_cvtepu8_epi32(_mm_srli_si128(lo, 8)));
+        _mm256_storeu_si256(dest + 2, _mm256_cvtepu8_epi32(hi));
+        _mm256_storeu_si256(dest + 3, _mm256_cvtepu8_epi32(_mm_srli_si128(hi, 8)));
+    }
+    return off;
+}
+
+[[gnu::target("avx2")]] std::size_t
+narrow16_avx2(const char16_t* in, std::size_t len, void* out) noexcept {
+    const auto  non_ascii = _mm256_set1_epi16(static_cast<short>(0xff80));
+    std::size_t off       = 0;
+    for (; off + 32 <= len; off += 32) {
+        auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + off));
+        auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + off + 16));
+        if (!_mm256_testz_si256(_mm256_or_si256(a, b), non_ascii)) {
+            break;
+        }
+        // Packing operates within each 128-bit lane, so the 64-bit quarters must be reordered
+        auto packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0b11'01'10'00);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(static_cast<char*>(out) + off), packed);
+    }
+    return off;
+}
+#endif
+
+/// The set of ASCII kernels to use on the current processor
+struct ascii_kernels {
+    std::size_t (*prefix)(const char8_t*, std::size_t) noexcept           = nullptr;
+    std::size_t (*widen16)(const char8_t*, std::size_t, void*) noexcept   = nullptr;
+    std::size_t (*widen32)(const char8_t*, std::size_t, void*) noexcept   = nullptr;
+    std::size_t (*narrow16)(const char16_t*, std::size_t, void*) noexcept = nullptr;
+};
+
+ascii_kernels select_kernels() noexcept {
+    ascii_kernels ret;
+    ret.prefix = &ascii_prefix_baseline;
+#if BTR_UTF_SSE2
+    ret.widen16  = &widen16_sse2;
+    ret.widen32  = &widen32_sse2;
+    ret.narrow16 = &narrow16_sse2;
+#elif BTR_UTF_NEON
+    ret.widen16  = &widen16_neon;
+    ret.widen32  = &widen32_neon;
+    ret.narrow16 = &narrow16_neon;
+#endif
+#if BTR_UTF_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        ret.prefix   = &ascii_prefix_avx2;
+        ret.widen16  = &widen16_avx2;
+        ret.widen32  = &widen32_avx2;
+        ret.narrow16 = &narrow16_avx2;
+    }
+#endif
+    return ret;
+}
+
+const ascii_kernels& active_kernels() noexcept {
+    static const ascii_kernels kernels = select_kernels();
+    return kernels;
+}
+
+}  // namespace
+
+std::size_t utf_detail::ascii_prefix_length(const char8_t* const ptr, std::size_t len) noexcept {
+    if (len < 64) {
+        // Not worth an indirect call
+        return ascii_prefix_baseline(ptr, len);
+    }
+    return active_kernels().prefix(ptr, len);
+}
+
 utf_detail::ll_decode_res utf_detail::ll_decode(const char16_t* in, const char16_t* stop) {
     neo_assert(invariant, in != stop, "decode_one(char16_t) called with empty range");
     char16_t val = *in;
@@ -26,7 +300,7 @@ utf_detail::ll_decode_res utf_detail::ll_decode(const char16_t* in, const char16
         char32_t ret  = high;
         ret <<= 10;
         ret |= low;
-        return {ret, 2};
+        return {ret + 0x10'000, 2};
     } else if (neo::between(val, 0x00, 0xd7ff) || neo::between(val, 0xe000, 0xffff)) {
         return {val, 1};
     } else {
@@ -102,7 +376,7 @@ utf_detail::ll_encode_res<char8_t> utf_detail::ll_encode(char32_t c, tag<char8_t
         *out++ = static_cast<char8_t>((0b00'111'111 & (c >> 6)) | 0b10'000000);
         *out++ = static_cast<char8_t>((0b00'111'111 & (c >> 0)) | 0b10'000000);
     } else if (neo::between(c, 0x10'000u, 0x10f'fffu)) {
-        *out++ = static_cast<char8_t>((0b1110'0000) | (c >> 18));
+        *out++ = static_cast<char8_t>((0b1111'0000) | (c >> 18));
         *out++ = static_cast<char8_t>((0b00'111'111 & (c >> 12)) | 0b10'000000);
         *out++ = static_cast<char8_t>((0b00'111'111 & (c >> 06)) | 0b10'000000);
         *out++ = static_cast<char8_t>((0b00'111'111 & (c >> 00)) | 0b10'000000);
@@ -122,7 +396,7 @@ utf_detail::ll_encode_res<char16_t> utf_detail::ll_encode(char32_t c, tag<char16
     } else if (neo::between(c, 0x10'000u, 0x10f'fffu)) {
         char32_t uprime = c - 0x10'000;
         auto     hi     = uprime >> 10;
-        auto     lo     = uprime & ((1u << 11) - 1u);
+        auto     lo     = uprime & ((1u << 10) - 1u);
         char16_t w1     = 0xd800 + static_cast<char16_t>(hi);
         char16_t w2     = 0xdc00 + static_cast<char16_t>(lo);
         *out++          = w1;
@@ -149,3 +423,397 @@ utf_detail::ll_encode_res<wchar_t> utf_detail::ll_encode(char32_t c, tag<wchar_t
         return res;
     }
 }
+
+utf_detail::ll_try_decode_res utf_detail::ll_try_decode(const char8_t* in,
+                                                        const char8_t* stop) noexcept {
+    const unsigned b0    = in[0];
+    const auto     avail = static_cast<std::size_t>(stop - in);
+    auto           cont  = [&](std::size_t idx, unsigned lo = 0x80, unsigned hi = 0xbf) {
+        return idx < avail && neo::between(static_cast<unsigned>(in[idx]), lo, hi);
+    };
+    // On error, the invalid sequence is the longest prefix of a well-formed sequence (and at least
+    // one code unit), so that decoding resumes at the first code unit that cannot be a part of it
+    if (b0 < 0x80) {
+        return {b0, 1, true};
+    } else if (b0 < 0xc2) {
+        // Either a continuation byte or an overlong two-byte sequence
+        return {replacement_character, 1, false};
+    } else if (b0 < 0xe0) {
+        if (!cont(1)) {
+            return {replacement_character, 1, false};
+        }
+        return {((b0 & 0x1fu) << 6) | (in[1] & 0x3fu), 2, true};
+    } else if (b0 < 0xf0) {
+        // Exclude overlong sequences and surrogates
+        if (!cont(1, b0 == 0xe0 ? 0xa0 : 0x80, b0 == 0xed ? 0x9f : 0xbf)) {
+            return {replacement_character, 1, false};
+        }
+        if (!cont(2)) {
+            return {replacement_character, 2, false};
+        }
+        return {((b0 & 0x0fu) << 12) | ((in[1] & 0x3fu) << 6) | (in[2] & 0x3fu), 3, true};
+    } else if (b0 < 0xf5) {
+        // Exclude overlong sequences and values beyond U+10FFFF
+        if (!cont(1, b0 == 0xf0 ? 0x90 : 0x80, b0 == 0xf4 ? 0x8f : 0xbf)) {
+            return {replacement_character, 1, false};
+        }
+        if (!cont(2)) {
+            return {replacement_character, 2, false};
+        }
+        if (!cont(3)) {
+            return {replacement_character, 3, false};
+        }
+        return {((b0 & 0x07u) << 18) | ((in[1] & 0x3fu) << 12) | ((in[2] & 0x3fu) << 6)
+                    | (in[3] & 0x3fu),
+                4,
+                true};
+    }
+    return {replacement_character, 1, false};
+}
+
+utf_detail::ll_try_decode_res utf_detail::ll_try_decode(const char16_t* in,
+                                                        const char16_t* stop) noexcept {
+    const char16_t c = in[0];
+    if (c < 0xd800 || c >= 0xe000) {
+        return {c, 1, true};
+    }
+    if (c >= 0xdc00 || stop - in < 2 || !neo::between(in[1], 0xdc00, 0xdfff)) {
+        return {replacement_character, 1, false};
+    }
+    return {(static_cast<char32_t>(c - 0xd800) << 10) + (in[1] - 0xdc00u) + 0x10'000, 2, true};
+}
+
+utf_detail::ll_try_decode_res utf_detail::ll_try_decode(const char32_t* in,
+                                                        const char32_t*) noexcept {
+    const char32_t c = in[0];
+    if (c > 0x10'ffff || neo::between(c, 0xd800u, 0xdfffu)) {
+        return {replacement_character, 1, false};
+    }
+    return {c, 1, true};
+}
+
+utf_detail::ll_try_decode_res utf_detail::ll_try_decode(const char* in, const char* stop) noexcept {
+    return ll_try_decode(reinterpret_cast<const char8_t*>(in),
+                         reinterpret_cast<const char8_t*>(stop));
+}
+
+utf_detail::ll_try_decode_res utf_detail::ll_try_decode(const wchar_t* in,
+                                                        const wchar_t* stop) noexcept {
+    static_assert(sizeof(wchar_t) == sizeof(char16_t) || sizeof(wchar_t) == sizeof(char32_t));
+    using unit = std::conditional_t<sizeof(wchar_t) == sizeof(char16_t), char16_t, char32_t>;
+    return ll_try_decode(reinterpret_cast<const unit*>(in), reinterpret_cast<const unit*>(stop));
+}
+
+namespace {
+
+/// The code unit type that is used to decode text held in the given character type
+template <typename Char>
+using decode_unit_t = std::conditional_t<sizeof(Char) == 1,
+                                         char8_t,
+                                         std::conditional_t<sizeof(Char) == 2, char16_t, char32_t>>;
+
+/// Encode a valid codepoint, returning the number of code units written
+template <typename Out>
+std::size_t encode_valid(char32_t c, Out* out) noexcept {
+    if constexpr (sizeof(Out) == 1) {
+        if (c < 0x800) {
+            out[0] = static_cast<Out>(0xc0 | (c >> 6));
+            out[1] = static_cast<Out>(0x80 | (c & 0x3f));
+            return 2;
+        } else if (c < 0x10'000) {
+            out[0] = static_cast<Out>(0xe0 | (c >> 12));
+            out[1] = static_cast<Out>(0x80 | ((c >> 6) & 0x3f));
+            out[2] = static_cast<Out>(0x80 | (c & 0x3f));
+            return 3;
+        } else {
+            out[0] = static_cast<Out>(0xf0 | (c >> 18));
+            out[1] = static_cast<Out>(0x80 | ((c >> 12) & 0x3f));
+            out[2] = static_cast<Out>(0x80 | ((c >> 6) & 0x3f));
+            out[3] = static_cast<Out>(0x80 | (c & 0x3f));
+            return 4;
+        }
+    } else if constexpr (sizeof(Out) == 2) {
+        if (c < 0x10'000) {
+            out[0] = static_cast<Out>(c);
+            return 1;
+        }
+        c -= 0x10'000;
+        out[0] = static_cast<Out>(0xd800 + (c >> 10));
+        out[1] = static_cast<Out>(0xdc00 + (c & 0x3ff));
+        return 2;
+    } else {
+        out[0] = static_cast<Out>(c);
+        return 1;
+    }
+}
+
+/// Convert a run of ASCII code units using the vectorized kernels, if there is one for the types
+template <typename In, typename Out>
+std::size_t convert_ascii_blocks(const In* in, std::size_t len, Out* out) noexcept {
+    const auto& kernels = active_kernels();
+    if constexpr (sizeof(In) == 1 && sizeof(Out) == 1) {
+        const auto n = kernels.prefix(reinterpret_cast<const char8_t*>(in), len);
+        std::memcpy(out, in, n);
+        return n;
+    } else if constexpr (sizeof(In) == 1 && sizeof(Out) == 2) {
+        return kernels.widen16 ? kernels.widen16(reinterpret_cast<const char8_t*>(in), len, out)
+                               : 0;
+    } else if constexpr (sizeof(In) == 1 && sizeof(Out) == 4) {
+        return kernels.widen32 ? kernels.widen32(reinterpret_cast<const char8_t*>(in), len, out)
+                               : 0;
+    } else if constexpr (sizeof(In) == 2 && sizeof(Out) == 1) {
+        return kernels.narrow16 ? kernels.narrow16(reinterpret_cast<const char16_t*>(in), len, out)
+                                : 0;
+    } else {
+        return 0;
+    }
+}
+
+}  // namespace
+
+template <utf_detail::code_unit In, utf_detail::code_unit Out>
+utf_convert_result utf_detail::transcode_units(const In* in, std::size_t len, Out* out) noexcept {
+    using unit                       = decode_unit_t<In>;
+    const auto* const  units         = reinterpret_cast<const unit*>(in);
+    const auto* const  stop          = units + len;
+    constexpr auto     scalar_stride = std::size_t{32};
+    utf_convert_result ret{0, 0};
+    while (ret.n_read < len) {
+        const auto n_ascii = convert_ascii_blocks(in + ret.n_read,
+                                                  len - ret.n_read,
+                                                  out + ret.n_written);
+        ret.n_read += n_ascii;
+        ret.n_written += n_ascii;
+        // Convert one codepoint at a time until the vector kernels are worth trying again
+        const auto scalar_stop = (std::min)(len, ret.n_read + scalar_stride);
+        while (ret.n_read < scalar_stop) {
+            const unit c = units[ret.n_read];
+            if (c < 0x80) {
+                out[ret.n_written++] = static_cast<Out>(c);
+                ++ret.n_read;
+                continue;
+            }
+            auto [cp, size, valid] = ll_try_decode(units + ret.n_read, stop);
+            if (!valid) {
+                return ret;
+            }
+            ret.n_read += size;
+            ret.n_written += encode_valid(cp, out + ret.n_written);
+        }
+    }
+    return ret;
+}
+
+template <utf_detail::code_unit In, utf_detail::code_unit Out>
+std::size_t utf_detail::transcoded_length(const In* in, std::size_t len) noexcept {
+    using unit              = decode_unit_t<In>;
+    const auto* const units = reinterpret_cast<const unit*>(in);
+    std::size_t       ret   = 0;
+    std::size_t       off   = 0;
+    if constexpr (sizeof(In) == 1) {
+        if constexpr (sizeof(Out) == 1) {
+            return len;
+        }
+        while (off < len) {
+            const auto n_ascii = ascii_prefix_length(units + off, len - off);
+            off += n_ascii;
+            ret += n_ascii;
+            for (; off < len && units[off] >= 0x80; ++off) {
+                const unit c = units[off];
+                // Count one code unit for each lead byte, and a second UTF-16 code unit for each
+                // four-byte sequence
+                ret += (c & 0xc0) != 0x80;
+                ret += sizeof(Out) == 2 && c >= 0xf0;
+            }
+        }
+    } else if constexpr (sizeof(In) == 2) {
+        for (; off < len; ++off) {
+            const unit c    = units[off];
+            const bool pair = neo::between(c, 0xd800, 0xdbff) && off + 1 < len
+                && neo::between(units[off + 1], 0xdc00, 0xdfff);
+            if constexpr (sizeof(Out) == 1) {
+                ret += c < 0x80 ? 1 : c < 0x800 ? 2 : pair ? 4 : 3;
+            } else {
+                ret += pair && sizeof(Out) == 2 ? 2 : 1;
+            }
+            off += pair;
+        }
+    } else {
+        for (; off < len; ++off) {
+            const unit c = units[off];
+            if constexpr (sizeof(Out) == 1) {
+                ret += c < 0x80 ? 1 : c < 0x800 ? 2 : c < 0x10'000 ? 3 : 4;
+            } else {
+                ret += sizeof(Out) == 2 && c >= 0x10'000 ? 2 : 1;
+            }
+        }
+    }
+    return ret;
+}
+
+namespace {
+
+/// Get the number of `Out` code units that encode the given valid codepoint
+template <typename Out>
+std::size_t encoded_length(char32_t c) noexcept {
+    if constexpr (sizeof(Out) == 1) {
+        return c < 0x80 ? 1 : c < 0x800 ? 2 : c < 0x10'000 ? 3 : 4;
+    } else if constexpr (sizeof(Out) == 2) {
+        return c < 0x10'000 ? 1 : 2;
+    } else {
+        return 1;
+    }
+}
+
+}  // namespace
+
+template <utf_detail::code_unit In, utf_detail::code_unit Out>
+std::size_t
+utf_detail::transcoded_length_lossy(const In* in, std::size_t len, bool replace) noexcept {
+    using unit              = decode_unit_t<In>;
+    const auto* const units = reinterpret_cast<const unit*>(in);
+    const auto* const stop  = units + len;
+    std::size_t       ret   = 0;
+    std::size_t       off   = 0;
+    while (off < len) {
+        if constexpr (sizeof(In) == 1) {
+            const auto n_ascii = ascii_prefix_length(units + off, len - off);
+            off += n_ascii;
+            ret += n_ascii;
+            if (off == len) {
+                break;
+            }
+        }
+        auto [cp, size, valid] = ll_try_decode(units + off, stop);
+        if (valid || replace) {
+            ret += encoded_length<Out>(cp);
+        }
+        off += size;
+    }
+    return ret;
+}
+
+template <utf_detail::code_unit In, utf_detail::code_unit Out>
+utf_convert_result utf_detail::transcode_units_lossy(const In*   in,
+                                                     std::size_t len,
+                                                     Out*        out,
+                                                     bool        replace) noexcept {
+    using unit                = decode_unit_t<In>;
+    const auto* const  units  = reinterpret_cast<const unit*>(in);
+    utf_convert_result ret{0, 0};
+    while (true) {
+        // Convert up to the next invalid sequence
+        auto part = transcode_units(in + ret.n_read, len - ret.n_read, out + ret.n_written);
+        ret.n_read += part.n_read;
+        ret.n_written += part.n_written;
+        if (ret.n_read == len) {
+            return ret;
+        }
+        auto bad = ll_try_decode(units + ret.n_read, units + len);
+        ret.n_read += bad.n_cus_taken;
+        if (replace) {
+            ret.n_written += encode_valid(replacement_character, out + ret.n_written);
+        }
+    }
+}
+
+template <utf_detail::code_unit Out>
+std::size_t
+utf_detail::transcode_valid_utf8(const char8_t* in, std::size_t len, Out* out) noexcept {
+    if constexpr (sizeof(Out) == 1) {
+        // Valid UTF-8 is already in the output encoding
+        std::memcpy(out, in, len);
+        return len;
+    }
+    constexpr auto scalar_stride = std::size_t{32};
+    std::size_t    n_read        = 0;
+    std::size_t    n_written     = 0;
+    while (n_read < len) {
+        const auto n_ascii = convert_ascii_blocks(in + n_read, len - n_read, out + n_written);
+        n_read += n_ascii;
+        n_written += n_ascii;
+        const auto scalar_stop = (std::min)(len, n_read + scalar_stride);
+        while (n_read < scalar_stop) {
+            auto [cp, size] = ll_decode_valid(in + n_read);
+            n_read += size;
+            if (cp < 0x80) {
+                out[n_written++] = static_cast<Out>(cp);
+            } else {
+                n_written += encode_valid(cp, out + n_written);
+            }
+        }
+    }
+    return n_written;
+}
+
+template std::size_t utf_detail::transcode_valid_utf8(const char8_t*, std::size_t, char*) noexcept;
+template std::size_t
+utf_detail::transcode_valid_utf8(const char8_t*, std::size_t, char8_t*) noexcept;
+template std::size_t
+utf_detail::transcode_valid_utf8(const char8_t*, std::size_t, char16_t*) noexcept;
+template std::size_t
+utf_detail::transcode_valid_utf8(const char8_t*, std::size_t, char32_t*) noexcept;
+template std::size_t
+utf_detail::transcode_valid_utf8(const char8_t*, std::size_t, wchar_t*) noexcept;
+
+#define BTR_INSTANTIATE_TRANSCODE(In, Out)                                                         \
+    template utf_convert_result utf_detail::transcode_units<In, Out>(const In*,                    \
+                                                                     std::size_t,                  \
+                                                                     Out*) noexcept;               \
+    template std::size_t utf_detail::transcoded_length<In, Out>(const In*, std::size_t) noexcept; \
+    template std::size_t utf_detail::transcoded_length_lossy<In, Out>(const In*,                   \
+                                                                      std::size_t,                 \
+                                                                      bool) noexcept;              \
+    template utf_convert_result utf_detail::transcode_units_lossy<In, Out>(const In*,              \
+                                                                           std::size_t,            \
+                                                                           Out*,                   \
+                                                                           bool) noexcept
+#define BTR_INSTANTIATE_TRANSCODE_FROM(In)                                                         \
+    BTR_INSTANTIATE_TRANSCODE(In, char);                                                           \
+    BTR_INSTANTIATE_TRANSCODE(In, char8_t);                                                        \
+    BTR_INSTANTIATE_TRANSCODE(In, char16_t);                                                       \
+    BTR_INSTANTIATE_TRANSCODE(In, char32_t);                                                       \
+    BTR_INSTANTIATE_TRANSCODE(In, wchar_t)
+
+BTR_INSTANTIATE_TRANSCODE_FROM(char);
+BTR_INSTANTIATE_TRANSCODE_FROM(char8_t);
+BTR_INSTANTIATE_TRANSCODE_FROM(char16_t);
+BTR_INSTANTIATE_TRANSCODE_FROM(char32_t);
+BTR_INSTANTIATE_TRANSCODE_FROM(wchar_t);
+
+#undef BTR_INSTANTIATE_TRANSCODE_FROM
+#undef BTR_INSTANTIATE_TRANSCODE
+
+namespace {
+
+/// Get the offset of the first invalid code unit sequence in the string, or the size of the string
+std::size_t find_invalid_utf8(std::u8string_view str) noexcept {
+    const auto  stop = str.data() + str.size();
+    std::size_t off  = 0;
+    while (off < str.size()) {
+        off += utf_detail::ascii_prefix_length(str.data() + off, str.size() - off);
+        // Validate the following run of non-ASCII codepoints
+        while (off < str.size() && str[off] >= 0x80) {
+            auto [cp, size, valid] = utf_detail::ll_try_decode(str.data() + off, stop);
+            if (!valid) {
+                return off;
+            }
+            off += size;
+        }
+    }
+    return str.size();
+}
+
+}  // namespace
+
+bool btr::validate_utf8(std::u8string_view str) noexcept {
+    return find_invalid_utf8(str) == str.size();
+}
+
+btr::valid_u8view::valid_u8view(u8view str)
+    : _view(str.u8string_view()) {
+    const auto bad = find_invalid_utf8(_view);
+    if (bad != _view.size()) {
+        utf_detail::throw_invalid(_view.data() + bad, _view.size() - bad);
+    }
+}
@@ -1,14 +1,22 @@
 #pragma once
 
+#include "./u8view.hpp"
+
+#include <neo/assert.hpp>
 #include <neo/fwd.hpp>
 #include <neo/iterator_facade.hpp>
+#include <neo/utility.hpp>
 #include <neo/tag.hpp>
 
+#include <algorithm>
+#include <concepts>
+#include <optional>
 #include <ranges>
 #include <span>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <vector>
 
 namespace btr {
 
@@ -20,13 +28,141 @@ struct utf_decode_error : std::runtime_error {
     using runtime_error::runtime_error;
 };
 
+/// U+FFFD REPLACEMENT CHARACTER, which stands in for invalid input
+inline constexpr char32_t replacement_character = 0xfffd;
+
+/**
+ * @brief Control how transcoding handles invalid code unit sequences
+ */
+enum class utf_error_policy {
+    /// Throw a utf_decode_error (the default)
+    throw_exception,
+    /// Replace each invalid sequence with U+FFFD REPLACEMENT CHARACTER
+    replace,
+    /// Omit invalid sequences from the output
+    skip,
+    /// Stop before the first invalid sequence, and report its position to the caller
+    report,
+};
+
+/**
+ * @brief The result of a bulk conversion between Unicode encodings
+ */
+struct utf_convert_result {
+    /// The number of input code units that were converted. If this is less than the size of the
+    /// input, then the input contains an invalid code unit sequence beginning at this offset.
+    std::size_t n_read;
+    /// The number of code units that were written to the output
+    std::size_t n_written;
+};
+
 namespace utf_detail {
 
+/// Character types that hold the code units of some Unicode encoding
+template <typename T>
+concept code_unit = std::same_as<T, char> || std::same_as<T, char8_t>
+    || std::same_as<T, char16_t> || std::same_as<T, char32_t> || std::same_as<T, wchar_t>;
+
+/**
+ * Convert the code units in [in, in + len) to the encoding of `Out`, writing the result to `out`.
+ * The encoding of each type is as described for transcode_string(). `out` must have room for at
+ * least transcoded_length(in, len) code units (which is at most max_transcoded_size<In, Out>(len)).
+ * Conversion stops before the first invalid code unit sequence.
+ *
+ * Runs of ASCII text are converted using vector instructions, selected at runtime for the current
+ * processor. Defined in utf.cpp for each pair of code unit types.
+ */
+template <code_unit In, code_unit Out>
+utf_convert_result transcode_units(const In* in, std::size_t len, Out* out) noexcept;
+
+/**
+ * Compute the number of `Out` code units that transcode_units() will write when given the same
+ * input. This does not validate the input, but if the input is invalid then transcode_units() will
+ * write no more than the returned number of code units. Defined in utf.cpp.
+ */
+template <code_unit In, code_unit Out>
+std::size_t transcoded_length(const In* in, std::size_t len) noexcept;
+
+/**
+ * As transcode_units(), but each invalid code unit sequence is replaced with U+FFFD (if `replace`)
+ * or omitted. `out` must have room for transcoded_length_lossy(in, len, replace) code units. The
+ * entire input is always consumed. Defined in utf.cpp.
+ */
+template <code_unit In, code_unit Out>
+utf_convert_result
+transcode_units_lossy(const In* in, std::size_t len, Out* out, bool replace) noexcept;
+
+/// Compute the exact number of code units that transcode_units_lossy() will write
+template <code_unit In, code_unit Out>
+std::size_t transcoded_length_lossy(const In* in, std::size_t len, bool replace) noexcept;
+
+/// The greatest number of `Out` code units that `len` code units of `In` may transcode to
+template <code_unit In, code_unit Out>
+constexpr std::size_t max_transcoded_size(std::size_t len) noexcept {
+    if constexpr (sizeof(Out) == 1) {
+        // A UTF-16 code unit may encode as three UTF-8 code units
+        return len * (sizeof(In) == 1 ? 1 : sizeof(In) == 2 ? 3 : 4);
+    } else if constexpr (sizeof(Out) == 2) {
+        return len * (sizeof(In) == 4 ? 2 : 1);
+    } else {
+        return len;
+    }
+}
+
 struct ll_decode_res {
     char32_t    codepoint;
     std::size_t n_cus_taken;
 };
 
+/**
+ * Decode a single codepoint from UTF-8 that is known to be valid (e.g. from a valid_u8view),
+ * without checking for errors. The behavior is undefined if the input is not valid.
+ */
+inline ll_decode_res ll_decode_valid(const char8_t* ptr) noexcept {
+    const char32_t b0 = ptr[0];
+    if (b0 < 0x80) {
+        return {b0, 1};
+    } else if (b0 < 0xe0) {
+        return {static_cast<char32_t>(((b0 & 0x1f) << 6) | (ptr[1] & 0x3f)), 2};
+    } else if (b0 < 0xf0) {
+        return {static_cast<char32_t>(((b0 & 0x0f) << 12) | ((ptr[1] & 0x3f) << 6)
+                                      | (ptr[2] & 0x3f)),
+                3};
+    } else {
+        return {static_cast<char32_t>(((b0 & 0x07) << 18) | ((ptr[1] & 0x3f) << 12)
+                                      | ((ptr[2] & 0x3f) << 6) | (ptr[3] & 0x3f)),
+                4};
+    }
+}
+
+/**
+ * As transcode_units(), for UTF-8 input that is known to be valid. Returns the number of code units
+ * written, which is transcoded_length<char8_t, Out>(in, len). Defined in utf.cpp.
+ */
+template <code_unit Out>
+std::size_t transcode_valid_utf8(const char8_t* in, std::size_t len, Out* out) noexcept;
+
+/// The result of ll_try_decode()
+struct ll_try_decode_res {
+    /// The decoded codepoint, or U+FFFD if the input is invalid
+    char32_t codepoint;
+    /// The number of code units decoded. If the input is invalid, the length of the invalid
+    /// sequence (at least one).
+    std::size_t n_cus_taken;
+    /// Whether the input began with a valid code unit sequence
+    bool valid;
+};
+
+/**
+ * Decode a single codepoint without throwing. Overlong UTF-8 sequences, surrogate codepoints, and
+ * codepoints beyond U+10FFFF are invalid. The input must not be empty.
+ */
+ll_try_decode_res ll_try_decode(const char8_t* ptr, const char8_t* stop) noexcept;
+ll_try_decode_res ll_try_decode(const char16_t* ptr, const char16_t* stop) noexcept;
+ll_try_decode_res ll_try_decode(const char32_t* ptr, const char32_t* stop) noexcept;
+ll_try_decode_res ll_try_decode(const char* ptr, const char* stop) noexcept;
+ll_try_decode_res ll_try_decode(const wchar_t* ptr, const wchar_t* stop) noexcept;
+
 inline ll_decode_res ll_decode(char32_t const* ptr, const char32_t*) noexcept {
     return ll_decode_res{*ptr, 1};
 }
@@ -53,8 +189,152 @@ ll_encode_res<wchar_t>  ll_encode(char32_t c, neo::tag<wchar_t>);
 
 inline bool ll_is_start_cu(char32_t&) noexcept { return true; }
 
+/// Throw a utf_decode_error that describes the invalid code unit sequence at the start of the input
+template <code_unit In>
+[[noreturn]] void throw_invalid(const In* in, std::size_t len) {
+    // The low-level decoder gives a more specific error for most invalid sequences
+    ll_decode(in, in + len);
+    throw utf_decode_error("Invalid Unicode code unit sequence");
+}
+
+/// Return the number of leading code units in [ptr, ptr + len) that are ASCII (less than 0x80)
+std::size_t ascii_prefix_length(const char8_t* ptr, std::size_t len) noexcept;
+
+/// Implements simple_case_fold() for codepoints outside of the ASCII range
+char32_t simple_case_fold_nonascii(char32_t c) noexcept;
+
 }  // namespace utf_detail
 
+/**
+ * @brief Determine whether every code unit of the given UTF-8 string is ASCII.
+ *
+ * The check is vectorized where the platform supports it.
+ */
+[[nodiscard]] inline bool is_ascii(std::u8string_view str) noexcept {
+    return utf_detail::ascii_prefix_length(str.data(), str.size()) == str.size();
+}
+
+/// @copydoc is_ascii(std::u8string_view)
+[[nodiscard]] inline bool is_ascii(std::string_view str) noexcept {
+    return utf_detail::ascii_prefix_length(reinterpret_cast<const char8_t*>(str.data()),
+                                           str.size())
+        == str.size();
+}
+
+/**
+ * @brief Determine whether the given string is entirely valid UTF-8.
+ *
+ * Overlong encodings, encoded surrogates, and codepoints beyond U+10FFFF are invalid.
+ */
+[[nodiscard]] bool validate_utf8(std::u8string_view str) noexcept;
+
+/// @copydoc validate_utf8(std::u8string_view)
+[[nodiscard]] inline bool validate_utf8(std::string_view str) noexcept {
+    return validate_utf8(
+        std::u8string_view{reinterpret_cast<const char8_t*>(str.data()), str.size()});
+}
+
+/**
+ * @brief A view of a UTF-8 string that is known to be valid.
+ *
+ * A valid_u8view can only be created by validating a string, so APIs that accept one (such as
+ * codepoint_range, transcode_string(), and fnmatch_pattern::test()) decode it without checking for
+ * errors. This allows text to be validated once when it is received, rather than each time it is
+ * used.
+ *
+ * Like u8view, this does not own the string that it views.
+ */
+class valid_u8view {
+    std::u8string_view _view;
+
+    struct prevalidated {};
+    constexpr valid_u8view(std::u8string_view sv, prevalidated) noexcept
+        : _view(sv) {}
+
+public:
+    /// Create a view of an empty string
+    constexpr valid_u8view() noexcept = default;
+
+    /**
+     * @brief Validate the given string, and create a view of it.
+     *
+     * @throws utf_decode_error If the string is not valid UTF-8
+     */
+    explicit valid_u8view(u8view str);
+
+    /// Validate the given string, and create a view of it only if it is valid UTF-8
+    [[nodiscard]] static std::optional<valid_u8view> try_create(u8view str) noexcept {
+        if (!validate_utf8(str.u8string_view())) {
+            return std::nullopt;
+        }
+        return valid_u8view{str.u8string_view(), prevalidated{}};
+    }
+
+    /// Return as a std::u8string_view
+    constexpr std::u8string_view u8string_view() const noexcept { return _view; }
+    /// Return as a std::string_view
+    std::string_view string_view() const noexcept {
+        return std::string_view(reinterpret_cast<const char*>(_view.data()), _view.size());
+    }
+
+    /// Convert to a u8view, which does not record that the string is valid
+    operator u8view() const noexcept { return u8view{_view}; }
+
+    /// Get a pointer to the char8_t data
+    constexpr const char8_t* u8data() const noexcept { return _view.data(); }
+
+    /// Obtain the number of bytes in the viewed string
+    constexpr std::size_t size_bytes() const noexcept { return _view.size(); }
+    /// Determine whether the viewed string is empty
+    constexpr bool empty() const noexcept { return _view.empty(); }
+
+    constexpr const char8_t* begin() const noexcept { return _view.data(); }
+    constexpr const char8_t* end() const noexcept { return _view.data() + _view.size(); }
+};
+
+/**
+ * @brief Convert UTF-8 text to UTF-16.
+ *
+ * @param in The UTF-8 text to convert
+ * @param out The destination. Must have room for at least `in.size()` code units.
+ */
+inline utf_convert_result utf8_to_utf16(std::u8string_view in, char16_t* out) noexcept {
+    return utf_detail::transcode_units(in.data(), in.size(), out);
+}
+
+/**
+ * @brief Convert UTF-8 text to UTF-32.
+ *
+ * @param in The UTF-8 text to convert
+ * @param out The destination. Must have room for at least `in.size()` code units.
+ */
+inline utf_convert_result utf8_to_utf32(std::u8string_view in, char32_t* out) noexcept {
+    return utf_detail::transcode_units(in.data(), in.size(), out);
+}
+
+/**
+ * @brief Convert UTF-16 text to UTF-8.
+ *
+ * @param in The UTF-16 text to convert
+ * @param out The destination. Must have room for at least `3 * in.size()` code units.
+ */
+inline utf_convert_result utf16_to_utf8(std::u16string_view in, char8_t* out) noexcept {
+    return utf_detail::transcode_units(in.data(), in.size(), out);
+}
+
+/**
+ * @brief Obtain the simple case folding of a codepoint.
+ *
+ * This uses the single-codepoint mappings of the Unicode case folding tables, so that codepoints
+ * that differ only in case will fold to the same codepoint. ASCII codepoints are folded inline.
+ */
+[[nodiscard]] inline char32_t simple_case_fold(char32_t c) noexcept {
+    if (c < 0x80) {
+        return (c >= U'A' && c <= U'Z') ? c + (U'a' - U'A') : c;
+    }
+    return utf_detail::simple_case_fold_nonascii(c);
+}
+
 /**
  * @brief Result of a single decode_one() operation
  *
@@ -111,6 +391,38 @@ decode_one_result<std::ranges::iterator_t<R>> decode_one(R&& r) {
     return decode_one(std::ranges::begin(r), std::ranges::end(r));
 }
 
+/**
+ * @brief Result of a single try_decode_one() operation
+ *
+ * @tparam Iter The iterator in the range of code units that was given
+ */
+template <typename Iter>
+struct try_decode_one_result {
+    /// The decoded Unicode codepoint, or U+FFFD REPLACEMENT CHARACTER if the input was invalid
+    char32_t codepoint;
+    /// Iterator past the end of the final decoded code unit, or past the invalid code units
+    Iter input;
+    /// Whether the code units were a valid encoding of a codepoint
+    bool valid;
+};
+
+/**
+ * @brief Decode a Unicode code point from the given range of code units, without throwing.
+ *
+ * If the input is invalid, the result holds U+FFFD, and `input` refers to the first code unit that
+ * may begin a valid sequence. This makes it suitable to replace, skip, or report invalid input.
+ *
+ * @param iter The beginning of a non-empty code unit range
+ * @param stop The end of the code unit range
+ */
+template <std::contiguous_iterator Iter>
+try_decode_one_result<Iter> try_decode_one(Iter iter, Iter stop) noexcept {
+    auto addr = std::to_address(iter);
+    auto len  = static_cast<std::size_t>(stop - iter);
+    auto res  = utf_detail::ll_try_decode(addr, addr + len);
+    return {res.codepoint, iter + static_cast<std::ptrdiff_t>(res.n_cus_taken), res.valid};
+}
+
 /**
  * @brief Create a range that decodes and iterates Unicode codepoints from a range of some UTF
  * encoded range
@@ -167,6 +479,230 @@ public:
 template <std::ranges::input_range R>
 explicit codepoint_range(R&&) -> codepoint_range<R>;
 
+/**
+ * @brief Iterates the codepoints of a valid_u8view. The string is known to be valid, so this
+ * decodes without checking for errors, never throws, and supports iterating backwards.
+ */
+template <>
+class codepoint_range<valid_u8view> {
+    valid_u8view _str;
+
+public:
+    using code_unit = char8_t;
+
+    explicit codepoint_range(valid_u8view str) noexcept
+        : _str(str) {}
+
+    class iterator : public neo::iterator_facade<iterator> {
+        const char8_t* _pos = nullptr;
+
+    public:
+        iterator() = default;
+        explicit iterator(const char8_t* pos) noexcept
+            : _pos(pos) {}
+
+        char32_t dereference() const noexcept {
+            return utf_detail::ll_decode_valid(_pos).codepoint;
+        }
+        void increment() noexcept { _pos += utf_detail::ll_decode_valid(_pos).n_cus_taken; }
+        void decrement() noexcept {
+            // Step back over continuation bytes to the preceding lead byte
+            do {
+                --_pos;
+            } while ((*_pos & 0xc0) == 0x80);
+        }
+
+        bool operator==(const iterator& o) const noexcept { return _pos == o._pos; }
+
+        /// Get a pointer to the first code unit of the current codepoint
+        const char8_t* base() const noexcept { return _pos; }
+    };
+
+    iterator begin() const noexcept { return iterator{_str.begin()}; }
+    iterator end() const noexcept { return iterator{_str.end()}; }
+};
+
+explicit codepoint_range(valid_u8view) -> codepoint_range<valid_u8view>;
+
+namespace utf_detail {
+
+/**
+ * Find the beginning of the code unit sequence that ends at `pos`, given that `begin` is the
+ * beginning of a sequence. This finds the same boundaries as decoding forward from `begin` with
+ * ll_try_decode(), including for invalid input.
+ */
+template <code_unit Char>
+const Char* ll_prev_boundary(const Char* begin, const Char* pos, const Char* stop) noexcept {
+    if constexpr (sizeof(Char) == 1) {
+        // Find the nearest preceding byte that is not a continuation byte. Every such byte begins a
+        // sequence, and no sequence is longer than four bytes.
+        auto lead = pos - 1;
+        auto is_continuation = [](Char c) {
+            return (static_cast<unsigned char>(c) & 0xc0) == 0x80;
+        };
+        while (lead != begin && pos - lead < 4 && is_continuation(*lead)) {
+            --lead;
+        }
+        if (lead + ll_try_decode(lead, stop).n_cus_taken == pos) {
+            return lead;
+        }
+        // The preceding byte is a stray continuation byte
+        return pos - 1;
+    } else if constexpr (sizeof(Char) == 2) {
+        if (pos - begin >= 2 && neo::between(static_cast<char16_t>(pos[-1]), 0xdc00, 0xdfff)
+            && neo::between(static_cast<char16_t>(pos[-2]), 0xd800, 0xdbff)) {
+            return pos - 2;
+        }
+        return pos - 1;
+    } else {
+        return pos - 1;
+    }
+}
+
+}  // namespace utf_detail
+
+/**
+ * @brief A bidirectional view of the codepoints in a contiguous Unicode string.
+ *
+ * Unlike codepoint_range, this view never throws: Invalid code unit sequences are presented as
+ * U+FFFD REPLACEMENT CHARACTER. Iterating backwards decodes from the end of each codepoint, so
+ * reaching a suffix of the string costs time proportional to the suffix.
+ *
+ * @tparam Char The code unit type of the string
+ */
+template <utf_detail::code_unit Char>
+class codepoint_view : public std::ranges::view_interface<codepoint_view<Char>> {
+    std::basic_string_view<Char> _str;
+
+public:
+    using code_unit = Char;
+
+    codepoint_view() = default;
+    explicit codepoint_view(std::basic_string_view<Char> str) noexcept
+        : _str(str) {}
+
+    class iterator : public neo::iterator_facade<iterator> {
+        const Char* _begin = nullptr;
+        const Char* _pos   = nullptr;
+        const Char* _stop  = nullptr;
+
+    public:
+        iterator() = default;
+        iterator(const Char* begin, const Char* pos, const Char* stop) noexcept
+            : _begin(begin)
+            , _pos(pos)
+            , _stop(stop) {}
+
+        char32_t dereference() const noexcept {
+            return utf_detail::ll_try_decode(_pos, _stop).codepoint;
+        }
+        void increment() noexcept { _pos += utf_detail::ll_try_decode(_pos, _stop).n_cus_taken; }
+        void decrement() noexcept { _pos = utf_detail::ll_prev_boundary(_begin, _pos, _stop); }
+
+        bool operator==(const iterator& o) const noexcept { return _pos == o._pos; }
+
+        /// Get a pointer to the first code unit of the current codepoint
+        const Char* base() const noexcept { return _pos; }
+        /// Get the offset of the current codepoint from the beginning of the string, in code units
+        std::size_t offset() const noexcept { return static_cast<std::size_t>(_pos - _begin); }
+    };
+
+    iterator begin() const noexcept { return iterator{_str.data(), _str.data(), _stop()}; }
+    iterator end() const noexcept { return iterator{_str.data(), _stop(), _stop()}; }
+
+    /// Obtain the underlying string
+    std::basic_string_view<Char> str() const noexcept { return _str; }
+
+private:
+    const Char* _stop() const noexcept { return _str.data() + _str.size(); }
+};
+
+template <typename Char>
+codepoint_view(std::basic_string_view<Char>) -> codepoint_view<Char>;
+
+/**
+ * @brief A view of the codepoints in a contiguous Unicode string that supports fast access to a
+ * codepoint by its index.
+ *
+ * The offset of every Nth codepoint is recorded when the view is created, so access by index needs
+ * to decode at most N - 1 codepoints. Invalid code unit sequences are presented as U+FFFD, as with
+ * codepoint_view.
+ *
+ * @tparam Char The code unit type of the string
+ */
+template <utf_detail::code_unit Char>
+class indexed_codepoint_view {
+    codepoint_view<Char>     _view;
+    std::size_t              _stride = 1;
+    std::size_t              _size   = 0;
+    std::vector<std::size_t> _offsets;
+
+public:
+    using iterator = typename codepoint_view<Char>::iterator;
+
+    /// The default distance between recorded codepoint offsets
+    static constexpr std::size_t default_stride = 32;
+
+    /**
+     * @brief Create an index of the codepoints in the given string
+     *
+     * @param str The string to index. The view refers to the string, and does not copy it.
+     * @param stride The distance between recorded codepoint offsets. Smaller values make access
+     *      faster, but use more memory. Must not be zero.
+     */
+    explicit indexed_codepoint_view(std::basic_string_view<Char> str,
+                                    std::size_t                  stride = default_stride)
+        : _view(str)
+        , _stride(stride) {
+        neo_assert(expects, stride != 0, "indexed_codepoint_view stride must not be zero");
+        const auto stop = _view.end();
+        for (auto it = _view.begin(); it != stop; ++it, ++_size) {
+            if (_size % _stride == 0) {
+                _offsets.push_back(it.offset());
+            }
+        }
+    }
+
+    /// The number of codepoints in the string
+    [[nodiscard]] std::size_t size() const noexcept { return _size; }
+    /// Whether the string is empty
+    [[nodiscard]] bool empty() const noexcept { return _size == 0; }
+
+    iterator begin() const noexcept { return _view.begin(); }
+    iterator end() const noexcept { return _view.end(); }
+
+    /// Obtain an iterator to the codepoint at the given index. `idx` may be equal to size().
+    [[nodiscard]] iterator iter_at(std::size_t idx) const noexcept {
+        neo_assert(expects, idx <= _size, "Codepoint index is out of range", idx, _size);
+        if (idx == _size) {
+            return end();
+        }
+        const auto str   = _view.str();
+        const auto first = str.data() + _offsets[idx / _stride];
+        auto       it    = iterator{str.data(), first, str.data() + str.size()};
+        for (auto n = idx % _stride; n != 0; --n) {
+            ++it;
+        }
+        return it;
+    }
+
+    /// Obtain the codepoint at the given index
+    [[nodiscard]] char32_t operator[](std::size_t idx) const noexcept { return *iter_at(idx); }
+
+    /// Obtain the code units of `count` codepoints beginning at codepoint index `pos`
+    [[nodiscard]] std::basic_string_view<Char> substr(std::size_t pos,
+                                                      std::size_t count) const noexcept {
+        auto first = iter_at(pos);
+        auto last  = iter_at(pos + (std::min)(count, _size - pos));
+        return {first.base(), static_cast<std::size_t>(last.base() - first.base())};
+    }
+};
+
+template <typename Char>
+indexed_codepoint_view(std::basic_string_view<Char>) -> indexed_codepoint_view<Char>;
+template <typename Char>
+indexed_codepoint_view(std::basic_string_view<Char>, std::size_t) -> indexed_codepoint_view<Char>;
+
 /**
  * @brief Transcode a string from one Unicode encoding to another
  *
@@ -181,14 +717,57 @@ explicit codepoint_range(R&&) -> codepoint_range<R>;
  * - wchar_t - Returns a std::wstring using the system's wide-encoding
  *             (UTF-16 on Windows, UTF-32 elsewhere).
  *
+ * Invalid input is handled according to the given error policy. The `replace` and `skip` policies
+ * require a contiguous input, and the `report` policy is only available with transcode_into().
+ *
  * @tparam CharOut The output character type.
+ * @tparam Policy How to handle invalid input.
  * @param rng A string to convert from. Must have a character value type.
  * @returns A new std::basic_string of the appropriate type
  */
-template <typename CharOut, std::ranges::input_range Range>
+template <typename CharOut,
+          utf_error_policy Policy = utf_error_policy::throw_exception,
+          std::ranges::input_range Range>
 decltype(auto) transcode_string(Range&& rng) {
-    codepoint_range            codepoints{rng};
+    static_assert(Policy != utf_error_policy::report,
+                  "Use transcode_into() to obtain the position of invalid input");
+    using char_in = std::remove_cv_t<std::ranges::range_value_t<Range>>;
     std::basic_string<CharOut> str;
+    if constexpr (std::same_as<std::remove_cvref_t<Range>, valid_u8view>
+                  && utf_detail::code_unit<CharOut>) {
+        // The input is known to be valid, so there is no need to check it again
+        str.resize(utf_detail::transcoded_length<char8_t, CharOut>(rng.u8data(), rng.size_bytes()));
+        utf_detail::transcode_valid_utf8(rng.u8data(), rng.size_bytes(), str.data());
+        return str;
+    } else if constexpr (std::ranges::contiguous_range<Range> && std::ranges::sized_range<Range>
+                         && utf_detail::code_unit<char_in> && utf_detail::code_unit<CharOut>) {
+        // Measure the output, then convert in bulk with a single allocation
+        const auto len  = static_cast<std::size_t>(std::ranges::size(rng));
+        const auto data = std::ranges::data(rng);
+        str.resize(utf_detail::transcoded_length<char_in, CharOut>(data, len));
+        auto res = utf_detail::transcode_units(data, len, str.data());
+        if (res.n_read == len) {
+            return str;
+        }
+        if constexpr (Policy == utf_error_policy::throw_exception) {
+            utf_detail::throw_invalid(data + res.n_read, len - res.n_read);
+        } else {
+            // Convert the remainder, dealing with the invalid input
+            const bool replace = Policy == utf_error_policy::replace;
+            const auto tail    = data + res.n_read;
+            const auto n_tail  = len - res.n_read;
+            str.resize(res.n_written
+                       + utf_detail::transcoded_length_lossy<char_in, CharOut>(tail,
+                                                                               n_tail,
+                                                                               replace));
+            utf_detail::transcode_units_lossy(tail, n_tail, str.data() + res.n_written, replace);
+            return str;
+        }
+    } else {
+        static_assert(Policy == utf_error_policy::throw_exception,
+                      "Error policies other than throw_exception require a contiguous input");
+    }
+    codepoint_range codepoints{rng};
     for (char32_t cp : codepoints) {
         auto enc = utf_detail::ll_encode(cp, tag_v<CharOut>);
         str.append(enc.units, enc.count);
@@ -196,6 +775,112 @@ decltype(auto) transcode_string(Range&& rng) {
     return str;
 }
 
+/**
+ * @brief The result of transcode_into()
+ */
+struct transcode_into_result {
+    /// The number of code units that were written to the output
+    std::size_t n_written;
+    /// The number of code units required to hold the entire output. If this is greater than the
+    /// size of the output, then nothing was written.
+    std::size_t n_needed;
+    /// The number of input code units that were converted. With utf_error_policy::report, if this
+    /// is less than the size of the input, then the input is invalid beginning at this offset.
+    std::size_t n_read;
+};
+
+/**
+ * @brief Transcode a string from one Unicode encoding to another, writing into caller-provided
+ * storage.
+ *
+ * The encodings are infered as for transcode_string(). Unless the error policy is
+ * `throw_exception`, this function does not throw.
+ *
+ * @tparam Policy How to handle invalid input.
+ * @param rng A contiguous string to convert from.
+ * @param out The destination. If it is too small for the output, nothing is written, and the
+ *      required size is returned in the result.
+ * @throws utf_decode_error If the input is not valid, with the `throw_exception` policy
+ */
+template <utf_detail::code_unit CharOut,
+          utf_error_policy Policy = utf_error_policy::throw_exception,
+          std::ranges::contiguous_range Range>
+requires utf_detail::code_unit<std::remove_cv_t<std::ranges::range_value_t<Range>>>
+transcode_into_result transcode_into(Range&& rng, std::span<CharOut> out) noexcept(
+    Policy != utf_error_policy::throw_exception) {
+    using char_in   = std::remove_cv_t<std::ranges::range_value_t<Range>>;
+    const auto len  = static_cast<std::size_t>(std::ranges::size(rng));
+    const auto data = std::ranges::data(rng);
+    const auto need = utf_detail::transcoded_length<char_in, CharOut>(data, len);
+    if constexpr (std::same_as<std::remove_cvref_t<Range>, valid_u8view>) {
+        // The input is known to be valid, so there is no need to check it again
+        if (need > out.size()) {
+            return {0, need, 0};
+        }
+        utf_detail::transcode_valid_utf8(data, len, out.data());
+        return {need, need, len};
+    }
+    if (need <= out.size()) {
+        auto res = utf_detail::transcode_units(data, len, out.data());
+        if (res.n_read == len || Policy == utf_error_policy::report) {
+            return {res.n_written, res.n_written, res.n_read};
+        }
+        if constexpr (Policy == utf_error_policy::throw_exception) {
+            utf_detail::throw_invalid(data + res.n_read, len - res.n_read);
+        }
+    } else if constexpr (Policy != utf_error_policy::replace && Policy != utf_error_policy::skip) {
+        return {0, need, 0};
+    }
+    // The input is invalid, or the output is too small to tell. Measure the output exactly.
+    const bool replace    = Policy == utf_error_policy::replace;
+    const auto need_lossy = utf_detail::transcoded_length_lossy<char_in, CharOut>(data,
+                                                                                 len,
+                                                                                 replace);
+    if (need_lossy > out.size()) {
+        return {0, need_lossy, 0};
+    }
+    auto res = utf_detail::transcode_units_lossy(data, len, out.data(), replace);
+    return {res.n_written, need_lossy, res.n_read};
+}
+
+/**
+ * @brief Transcode a string from one Unicode encoding to another, replacing the content of an
+ * existing string.
+ *
+ * The storage of `out` is reused, so this does not allocate if `out` already has enough capacity.
+ *
+ * @tparam Policy How to handle invalid input. The `report` policy is not supported.
+ * @throws utf_decode_error If the input is not valid, with the `throw_exception` policy
+ */
+template <utf_detail::code_unit CharOut,
+          utf_error_policy Policy = utf_error_policy::throw_exception,
+          std::ranges::contiguous_range Range>
+requires utf_detail::code_unit<std::remove_cv_t<std::ranges::range_value_t<Range>>>
+void transcode_into(Range&& rng, std::basic_string<CharOut>& out) {
+    static_assert(Policy != utf_error_policy::report,
+                  "Use a span output to obtain the position of invalid input");
+    using char_in   = std::remove_cv_t<std::ranges::range_value_t<Range>>;
+    const auto len  = static_cast<std::size_t>(std::ranges::size(rng));
+    const auto data = std::ranges::data(rng);
+    out.resize(utf_detail::transcoded_length<char_in, CharOut>(data, len));
+    if constexpr (std::same_as<std::remove_cvref_t<Range>, valid_u8view>) {
+        utf_detail::transcode_valid_utf8(data, len, out.data());
+        return;
+    }
+    auto res = utf_detail::transcode_units(data, len, out.data());
+    if (res.n_read == len) {
+        return;
+    }
+    if constexpr (Policy == utf_error_policy::throw_exception) {
+        out.clear();
+        utf_detail::throw_invalid(data + res.n_read, len - res.n_read);
+    } else {
+        const bool replace = Policy == utf_error_policy::replace;
+        out.resize(utf_detail::transcoded_length_lossy<char_in, CharOut>(data, len, replace));
+        utf_detail::transcode_units_lossy(data, len, out.data(), replace);
+    }
+}
+
 /// Encoding the given string as a UTF-8 std::u8string
 std::u8string u8encode(std::ranges::contiguous_range auto&& rng) {
     return transcode_string<char8_t>(NEO_FWD(rng));
@@ -2,6 +2,9 @@
 
 #include <catch2/catch.hpp>
 
+#include <cstdint>
+#include <string>
+
 using namespace std::literals;
 
 TEST_CASE("Encode a simple string") {
@@ -14,3 +17,292 @@ TEST_CASE("Encode a simple string") {
     auto s2 = btr::transcode_string<char>("€42"sv);
     CHECK(s2 == "€42");
 }
+
+TEST_CASE("Check for ASCII strings") {
+    CHECK(btr::is_ascii(""sv));
+    CHECK(btr::is_ascii("Hello!"sv));
+    CHECK_FALSE(btr::is_ascii("€"sv));
+    for (std::size_t len = 1; len < 40; ++len) {
+        for (std::size_t bad = 0; bad < len; ++bad) {
+            std::u8string str(len, u8'a');
+            CHECK(btr::is_ascii(str));
+            str[bad] = 0xc3;
+            CAPTURE(len, bad);
+            CHECK_FALSE(btr::is_ascii(str));
+            CHECK(btr::utf_detail::ascii_prefix_length(str.data(), str.size()) == bad);
+        }
+    }
+}
+
+TEST_CASE("Simple case folding") {
+    CHECK(btr::simple_case_fold(U'A') == U'a');
+    CHECK(btr::simple_case_fold(U'a') == U'a');
+    CHECK(btr::simple_case_fold(U'@') == U'@');
+    CHECK(btr::simple_case_fold(U'Ä') == U'ä');
+    CHECK(btr::simple_case_fold(U'Ā') == U'ā');
+    CHECK(btr::simple_case_fold(U'ā') == U'ā');
+    CHECK(btr::simple_case_fold(U'Σ') == U'σ');
+    CHECK(btr::simple_case_fold(U'ς') == U'σ');
+    CHECK(btr::simple_case_fold(U'Ж') == U'ж');
+    CHECK(btr::simple_case_fold(U'\u212a') == U'k');  // KELVIN SIGN
+    CHECK(btr::simple_case_fold(U'ẞ') == U'ß');
+    CHECK(btr::simple_case_fold(U'ß') == U'ß');
+    CHECK(btr::simple_case_fold(U'Ａ') == U'ａ');
+    CHECK(btr::simple_case_fold(U'😀') == U'😀');
+}
+
+TEST_CASE("Validate UTF-8") {
+    CHECK(btr::validate_utf8(""sv));
+    CHECK(btr::validate_utf8("Hello!"sv));
+    CHECK(btr::validate_utf8("€42 😀 Ж"sv));
+    CHECK(btr::validate_utf8("\xed\x9f\xbf"sv));      // U+D7FF
+    CHECK(btr::validate_utf8("\xf4\x8f\xbf\xbf"sv));  // U+10FFFF
+    CHECK_FALSE(btr::validate_utf8("\x80"sv));
+    CHECK_FALSE(btr::validate_utf8("\xc0\x80"sv));          // Overlong NUL
+    CHECK_FALSE(btr::validate_utf8("\xe0\x80\x80"sv));      // Overlong
+    CHECK_FALSE(btr::validate_utf8("\xf0\x80\x80\x80"sv));  // Overlong
+    CHECK_FALSE(btr::validate_utf8("\xed\xa0\x80"sv));      // Surrogate
+    CHECK_FALSE(btr::validate_utf8("\xf4\x90\x80\x80"sv));  // Beyond U+10FFFF
+    CHECK_FALSE(btr::validate_utf8("\xe2\x82"sv));          // Truncated
+    CHECK_FALSE(btr::validate_utf8("\xff"sv));
+    std::string long_str(100, 'a');
+    long_str[70] = '\x80';
+    CHECK_FALSE(btr::validate_utf8(long_str));
+}
+
+namespace {
+
+/// Encode the given codepoints one at a time
+template <typename Char>
+std::basic_string<Char> encode_each(const std::u32string& cps) {
+    std::basic_string<Char> ret;
+    for (char32_t c : cps) {
+        auto enc = btr::utf_detail::ll_encode(c, btr::tag_v<Char>);
+        ret.append(enc.units, enc.count);
+    }
+    return ret;
+}
+
+}  // namespace
+
+TEST_CASE("Bulk transcoding agrees with codepoint-at-a-time transcoding") {
+    std::u32string cps;
+    // A mix of long ASCII runs (to use the vector kernels) and codepoints of each encoded length
+    const char32_t others[] = {U'é', U'€', U'😀', U'￿', U'\U0010ffff', U'ࠀ', U'߿'};
+    std::uint32_t  seed     = 42;
+    auto           rand     = [&] { return (seed = seed * 1103515245 + 12345) >> 16; };
+    for (int i = 0; i < 2000; ++i) {
+        if (rand() % 8 == 0) {
+            cps.push_back(others[rand() % std::size(others)]);
+        } else {
+            cps.push_back(static_cast<char32_t>(rand() % 0x80));
+        }
+    }
+
+    const auto u8  = encode_each<char8_t>(cps);
+    const auto u16 = encode_each<char16_t>(cps);
+    for (std::size_t len = 0; len < cps.size(); len += 1 + len / 4) {
+        const auto sub   = cps.substr(0, len);
+        const auto sub8  = encode_each<char8_t>(sub);
+        const auto sub16 = encode_each<char16_t>(sub);
+        CAPTURE(len);
+        CHECK(btr::validate_utf8(sub8));
+        CHECK(btr::transcode_string<char16_t>(sub8) == sub16);
+        CHECK(btr::transcode_string<char32_t>(sub8) == sub);
+        CHECK(btr::transcode_string<char8_t>(sub16) == sub8);
+        CHECK(btr::transcode_string<char8_t>(sub) == sub8);
+        CHECK(btr::transcode_string<char32_t>(sub16) == sub);
+        CHECK(btr::transcode_string<wchar_t>(sub8) == encode_each<wchar_t>(sub));
+    }
+
+    // Conversion stops at invalid input
+    auto bad_pos = u8.find_first_of(u8'a', 1500);
+    auto bad     = u8;
+    bad[bad_pos] = 0xff;
+    std::u16string out(bad.size(), u'\0');
+    auto           res = btr::utf8_to_utf16(bad, out.data());
+    CHECK(res.n_read == bad_pos);
+    CHECK(out.substr(0, res.n_written) == btr::transcode_string<char16_t>(bad.substr(0, bad_pos)));
+    CHECK_THROWS_AS(btr::transcode_string<char16_t>(bad), btr::utf_decode_error);
+
+    bad_pos        = u16.find_first_of(u'a', 1000);
+    auto bad16     = u16;
+    bad16[bad_pos] = 0xdc00;  // An unpaired low surrogate
+    std::u8string out8(bad16.size() * 3, u8'\0');
+    CHECK(btr::utf16_to_utf8(bad16, out8.data()).n_read == bad_pos);
+}
+
+TEST_CASE("Transcode into existing storage") {
+    const auto input = u8"Hello, 😀 and €!"sv;
+
+    char16_t buf[8] = {};
+    auto     res    = btr::transcode_into(input, std::span<char16_t>{buf});
+    CHECK(res.n_written == 0);
+    CHECK(res.n_needed == 16);
+    CHECK(buf[0] == u'\0');
+
+    char16_t big[32] = {};
+    res              = btr::transcode_into(input, std::span<char16_t>{big});
+    CHECK(res.n_written == 16);
+    CHECK(std::u16string_view(big, res.n_written) == u"Hello, 😀 and €!");
+
+    std::u16string str;
+    str.reserve(64);
+    const auto cap = str.capacity();
+    for (int i = 0; i < 4; ++i) {
+        btr::transcode_into(input, str);
+        CHECK(str == u"Hello, 😀 and €!");
+        CHECK(str.capacity() == cap);
+    }
+
+    CHECK_THROWS_AS(btr::transcode_into("\xc0\x80"sv, str), btr::utf_decode_error);
+    CHECK_THROWS_AS(btr::transcode_string<char16_t>("\xe0\x80\x80"sv), btr::utf_decode_error);
+}
+
+TEST_CASE("Handle invalid input according to an error policy") {
+    using btr::utf_error_policy;
+    // An invalid continuation, a truncated three-byte sequence, an encoded surrogate, and a stray
+    // continuation byte
+    const auto dirty = "a\xc3(b\xe2\x82z\xed\xa0\x80!\x80"sv;
+
+    CHECK_THROWS_AS(btr::transcode_string<char16_t>(dirty), btr::utf_decode_error);
+    CHECK(btr::transcode_string<char16_t, utf_error_policy::replace>(dirty)
+          == u"a�(b�z���!�");
+    CHECK(btr::transcode_string<char8_t, utf_error_policy::skip>(dirty) == u8"a(bz!");
+    CHECK(btr::transcode_string<char8_t, utf_error_policy::replace>(dirty)
+          == u8"a�(b�z���!�");
+    // Clean input is unaffected
+    CHECK(btr::transcode_string<char16_t, utf_error_policy::skip>("€42"sv) == u"€42");
+
+    char16_t buf[32] = {};
+    auto res = btr::transcode_into<char16_t, utf_error_policy::report>(dirty, std::span{buf});
+    static_assert(
+        noexcept(btr::transcode_into<char16_t, utf_error_policy::report>(dirty, std::span{buf})));
+    CHECK(res.n_read == 1);
+    CHECK(res.n_written == 1);
+
+    res = btr::transcode_into<char16_t, utf_error_policy::skip>(dirty, std::span{buf});
+    CHECK(res.n_read == dirty.size());
+    CHECK(std::u16string_view(buf, res.n_written) == u"a(bz!");
+
+    // Too small for the output
+    res = btr::transcode_into<char16_t, utf_error_policy::replace>(dirty, std::span{buf, 5});
+    CHECK(res.n_written == 0);
+    CHECK(res.n_needed == 11);
+
+    std::u32string str;
+    btr::transcode_into<char32_t, utf_error_policy::replace>(u"x\xd800y"sv, str);
+    CHECK(str == U"x�y");
+
+    // Decode single codepoints
+    auto one = btr::try_decode_one(dirty.begin() + 1, dirty.end());
+    CHECK_FALSE(one.valid);
+    CHECK(one.codepoint == btr::replacement_character);
+    CHECK(one.input == dirty.begin() + 2);
+    one = btr::try_decode_one(dirty.begin() + 4, dirty.end());
+    CHECK_FALSE(one.valid);
+    CHECK(one.input == dirty.begin() + 6);
+    one = btr::try_decode_one(dirty.begin() + 7, dirty.end());
+    CHECK_FALSE(one.valid);
+    CHECK(one.input == dirty.begin() + 8);
+    const auto euro = "€"sv;
+    one             = btr::try_decode_one(euro.begin(), euro.end());
+    CHECK(one.valid);
+    CHECK(one.codepoint == U'€');
+    CHECK(one.input == euro.end());
+}
+
+TEST_CASE("Iterate codepoints in both directions") {
+    const auto str  = u8"a€😀ж\xc3\x80\x80\xf0\x80\x80z"sv;
+    const auto view = btr::codepoint_view{str};
+    static_assert(std::ranges::bidirectional_range<decltype(view)>);
+
+    std::u32string forward;
+    for (char32_t c : view) {
+        forward.push_back(c);
+    }
+    CHECK(forward == U"a€😀жÀ����z");
+
+    // Walking backward finds the same boundaries, even for invalid input
+    std::u32string backward;
+    for (auto it = view.end(); it != view.begin();) {
+        --it;
+        backward.insert(backward.begin(), *it);
+    }
+    CHECK(backward == forward);
+
+    const auto u16  = u"x😀\xdc00y"sv;
+    auto       last = btr::codepoint_view{u16}.end();
+    CHECK(*--last == U'y');
+    CHECK(*--last == U'�');
+    CHECK(*--last == U'😀');
+    CHECK(last.offset() == 1);
+}
+
+TEST_CASE("Access codepoints by index") {
+    std::u8string  str;
+    std::u32string expect;
+    for (int i = 0; i < 500; ++i) {
+        const char32_t c = i % 3 == 0 ? U'a' : i % 3 == 1 ? U'é' : U'😀';
+        expect.push_back(c);
+        auto enc = btr::utf_detail::ll_encode(c, btr::tag_v<char8_t>);
+        str.append(enc.units, enc.count);
+    }
+    for (std::size_t stride : {1, 7, 32, 1000}) {
+        btr::indexed_codepoint_view idx{std::u8string_view{str}, stride};
+        CHECK(idx.size() == expect.size());
+        for (std::size_t n = 0; n < expect.size(); n += 13) {
+            CAPTURE(stride, n);
+            CHECK(idx[n] == expect[n]);
+        }
+        CHECK(idx.substr(3, 2) == u8"a\xc3\xa9");
+        CHECK(idx.substr(498, 10) == u8"a\xc3\xa9");
+        CHECK(idx.iter_at(500) == idx.end());
+    }
+}
+
+TEST_CASE("Validate once, then decode without checking") {
+    const auto str   = u8"a€😀ж z"sv;
+    const auto valid = btr::valid_u8view{str};
+    static_assert(std::ranges::contiguous_range<btr::valid_u8view>);
+    CHECK(valid.u8string_view() == str);
+    CHECK_THROWS_AS(btr::valid_u8view{"foo\xffz"sv}, btr::utf_decode_error);
+    CHECK_FALSE(btr::valid_u8view::try_create("\xed\xa0\x80"sv));
+    CHECK(btr::valid_u8view::try_create(str)->size_bytes() == str.size());
+
+    // Codepoints are decoded in both directions
+    btr::codepoint_range codepoints{valid};
+    static_assert(std::same_as<decltype(codepoints), btr::codepoint_range<btr::valid_u8view>>);
+    std::u32string forward;
+    for (char32_t c : codepoints) {
+        forward.push_back(c);
+    }
+    CHECK(forward == U"a€😀ж z");
+    auto last = codepoints.end();
+    CHECK(*--last == U'z');
+    CHECK(*--last == U' ');
+    CHECK(*--last == U'ж');
+    CHECK(*--last == U'😀');
+
+    // Transcoding gives the same result as for an unvalidated string
+    std::u8string long_str;
+    for (int i = 0; i < 50; ++i) {
+        long_str.append(i % 5 ? u8"ascii text " : u8"ĉu ĝi 😀 ");
+    }
+    const auto long_valid = btr::valid_u8view{long_str};
+    CHECK(btr::transcode_string<char16_t>(long_valid)
+          == btr::transcode_string<char16_t>(std::u8string_view{long_str}));
+    CHECK(btr::transcode_string<char32_t>(long_valid)
+          == btr::transcode_string<char32_t>(std::u8string_view{long_str}));
+    CHECK(btr::transcode_string<wchar_t>(long_valid)
+          == btr::transcode_string<wchar_t>(std::u8string_view{long_str}));
+    CHECK(btr::transcode_string<char>(long_valid) == std::string(long_str.begin(), long_str.end()));
+
+    std::u16string out;
+    btr::transcode_into(long_valid, out);
+    CHECK(out == btr::transcode_string<char16_t>(std::u8string_view{long_str}));
+    char32_t buf[4];
+    auto     res = btr::transcode_into(valid, std::span<char32_t>{buf});
+    CHECK(res.n_written == 0);
+    CHECK(res.n_needed == 6);
+}
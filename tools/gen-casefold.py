@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+"""
+Generate src/btr/casefold.cpp, which implements btr::simple_case_fold() for non-ASCII codepoints.
+
+The table is derived from the Unicode character database that is bundled with Python. Usage:
+
+    python3 tools/gen-casefold.py > src/btr/casefold.cpp
+"""
+
+import sys
+import unicodedata
+
+
+def simple_fold(cp: int) -> int:
+    """
+    Get the simple case folding of the given codepoint (CaseFolding.txt statuses C and S). Where the
+    full folding produces more than one codepoint, fall back to the single-codepoint lowercase.
+    """
+    c = chr(cp)
+    folded = c.casefold()
+    if len(folded) != 1:
+        lower = c.lower()
+        folded = lower if len(lower) == 1 else c
+    return ord(folded)
+
+
+def build_runs():
+    """
+    Build a list of [first, last, delta, stride] runs. Every 'stride'th codepoint in [first, last]
+    folds to itself plus 'delta'.
+    """
+    runs = []
+    for cp in range(0x80, 0x110000):
+        if 0xD800 <= cp < 0xE000:
+            continue
+        delta = simple_fold(cp) - cp
+        if delta == 0:
+            continue
+        if runs:
+            run = runs[-1]
+            if run[2] == delta and cp - run[1] == run[3]:
+                run[1] = cp
+                continue
+            if run[2] == delta and run[0] == run[1] and cp - run[1] == 2:
+                run[1] = cp
+                run[3] = 2
+                continue
+        runs.append([cp, cp, delta, 1])
+    return runs
+
+
+def main():
+    runs = build_runs()
+    out = sys.stdout
+    out.write(f'''// This file is generated by tools/gen-casefold.py. Do not edit.
+// Unicode version {unicodedata.unidata_version}
+
+#include "./utf.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+
+namespace {{
+
+struct fold_run {{
+    char32_t     first;
+    char32_t     last;
+    std::int32_t delta;
+    std::uint8_t stride;
+}};
+
+constexpr fold_run fold_runs[] = {{
+''')
+    for first, last, delta, stride in runs:
+        out.write(f'    {{0x{first:04X}, 0x{last:04X}, {delta}, {stride}}},\n')
+    out.write('''};
+
+}  // namespace
+
+char32_t btr::utf_detail::simple_case_fold_nonascii(char32_t c) noexcept {
+    auto it = std::upper_bound(std::begin(fold_runs),
+                               std::end(fold_runs),
+                               c,
+                               [](char32_t cp, const fold_run& run) { return cp < run.first; });
+    if (it == std::begin(fold_runs)) {
+        return c;
+    }
+    --it;
+    if (c > it->last || (c - it->first) % it->stride != 0) {
+        return c;
+    }
+    return static_cast<char32_t>(static_cast<std::int32_t>(c) + it->delta);
+}
+''')
+
+
+if __name__ == '__main__':
+    main()
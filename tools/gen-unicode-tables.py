@@ -0,0 +1,300 @@
+#!/usr/bin/env python3
+"""
+Generate src/btr/unicode_tables.cpp, which holds the character properties that are used for
+Unicode normalization and grapheme cluster segmentation in btr/unicode.hpp.
+
+The tables are derived from the Unicode character database that is bundled with Python. Usage:
+
+    python3 tools/gen-unicode-tables.py > src/btr/unicode_tables.cpp
+
+Python does not expose the Grapheme_Cluster_Break property, so it is derived from other character
+properties as described in UAX #29, Table 2. Extended_Pictographic is not available at all, so its
+ranges (from emoji-data.txt) are listed below.
+"""
+
+import sys
+import unicodedata
+
+# Extended_Pictographic=Yes, from emoji-data.txt. The property is assigned to large blocks of
+# reserved codepoints in advance, so it rarely changes between Unicode versions.
+EXTENDED_PICTOGRAPHIC = [
+    (0x00A9, 0x00A9), (0x00AE, 0x00AE), (0x203C, 0x203C), (0x2049, 0x2049), (0x2122, 0x2122),
+    (0x2139, 0x2139), (0x2194, 0x2199), (0x21A9, 0x21AA), (0x231A, 0x231B), (0x2328, 0x2328),
+    (0x2388, 0x2388), (0x23CF, 0x23CF), (0x23E9, 0x23F3), (0x23F8, 0x23FA), (0x24C2, 0x24C2),
+    (0x25AA, 0x25AB), (0x25B6, 0x25B6), (0x25C0, 0x25C0), (0x25FB, 0x25FE), (0x2600, 0x2605),
+    (0x2607, 0x2612), (0x2614, 0x2685), (0x2690, 0x2705), (0x2708, 0x2712), (0x2714, 0x2714),
+    (0x2716, 0x2716), (0x271D, 0x271D), (0x2721, 0x2721), (0x2728, 0x2728), (0x2733, 0x2734),
+    (0x2744, 0x2744), (0x2747, 0x2747), (0x274C, 0x274C), (0x274E, 0x274E), (0x2753, 0x2755),
+    (0x2757, 0x2757), (0x2763, 0x2767), (0x2795, 0x2797), (0x27A1, 0x27A1), (0x27B0, 0x27B0),
+    (0x27BF, 0x27BF), (0x2934, 0x2935), (0x2B05, 0x2B07), (0x2B1B, 0x2B1C), (0x2B50, 0x2B50),
+    (0x2B55, 0x2B55), (0x3030, 0x3030), (0x303D, 0x303D), (0x3297, 0x3297), (0x3299, 0x3299),
+    (0x1F000, 0x1F0FF), (0x1F10D, 0x1F10F), (0x1F12F, 0x1F12F), (0x1F16C, 0x1F171),
+    (0x1F17E, 0x1F17F), (0x1F18E, 0x1F18E), (0x1F191, 0x1F19A), (0x1F1AD, 0x1F1E5),
+    (0x1F201, 0x1F20F), (0x1F21A, 0x1F21A), (0x1F22F, 0x1F22F), (0x1F232, 0x1F23A),
+    (0x1F23C, 0x1F23F), (0x1F249, 0x1F3FA), (0x1F400, 0x1F53D), (0x1F546, 0x1F64F),
+    (0x1F680, 0x1F6FF), (0x1F774, 0x1F77F), (0x1F7D5, 0x1F7FF), (0x1F80C, 0x1F80F),
+    (0x1F848, 0x1F84F), (0x1F85A, 0x1F85F), (0x1F888, 0x1F88F), (0x1F8AE, 0x1F8FF),
+    (0x1F90C, 0x1F93A), (0x1F93C, 0x1F945), (0x1F947, 0x1FAFF), (0x1FC00, 0x1FFFD),
+]
+
+# Other_Grapheme_Extend=Yes, from PropList.txt
+OTHER_GRAPHEME_EXTEND = [
+    (0x09BE, 0x09BE), (0x09D7, 0x09D7), (0x0B3E, 0x0B3E), (0x0B57, 0x0B57), (0x0BBE, 0x0BBE),
+    (0x0BD7, 0x0BD7), (0x0CC2, 0x0CC2), (0x0CD5, 0x0CD6), (0x0D3E, 0x0D3E), (0x0D57, 0x0D57),
+    (0x0DCF, 0x0DCF), (0x0DDF, 0x0DDF), (0x1B35, 0x1B35), (0x200C, 0x200C), (0x302E, 0x302F),
+    (0xFF9E, 0xFF9F), (0x1133E, 0x1133E), (0x11357, 0x11357), (0x114B0, 0x114B0),
+    (0x114BD, 0x114BD), (0x115AF, 0x115AF), (0x11930, 0x11930), (0x1D165, 0x1D165),
+    (0x1D16E, 0x1D172), (0xE0020, 0xE007F),
+]
+
+# Prepended_Concatenation_Mark=Yes, from PropList.txt
+PREPENDED_CONCATENATION_MARK = [
+    (0x0600, 0x0605), (0x06DD, 0x06DD), (0x070F, 0x070F), (0x0890, 0x0891), (0x08E2, 0x08E2),
+    (0x110BD, 0x110BD), (0x110CD, 0x110CD),
+]
+
+# Indic_Syllabic_Category=Consonant_Preceding_Repha or Consonant_Prefixed, from
+# IndicSyllabicCategory.txt
+PREPEND_INDIC = [
+    (0x0D4E, 0x0D4E), (0x111C2, 0x111C3), (0x1193F, 0x1193F), (0x11941, 0x11941),
+    (0x11A3A, 0x11A3A), (0x11A84, 0x11A89), (0x11D46, 0x11D46),
+]
+
+# Spacing marks that UAX #29 excludes from, or adds to, Grapheme_Cluster_Break=SpacingMark
+SPACING_MARK_EXCEPTIONS = [
+    (0x102B, 0x102C), (0x1038, 0x1038), (0x1062, 0x1064), (0x1067, 0x106D), (0x1083, 0x1083),
+    (0x1087, 0x108C), (0x108F, 0x108F), (0x109A, 0x109C), (0x1A61, 0x1A61), (0x1A63, 0x1A64),
+    (0xAA7B, 0xAA7B), (0xAA7D, 0xAA7D), (0x11720, 0x11721),
+]
+SPACING_MARK_ADDITIONS = [(0x0E33, 0x0E33), (0x0EB3, 0x0EB3)]
+
+# Default_Ignorable_Code_Point=Yes codepoints that are unassigned, which UAX #29 makes Control
+UNASSIGNED_DEFAULT_IGNORABLE = [(0xE0000, 0xE0000), (0xE0002, 0xE001F), (0xE0080, 0xE00FF),
+                                (0xE01F0, 0xE0FFF)]
+
+# Must match btr::unicode_detail::grapheme_break
+GCB_NAMES = [
+    'other', 'cr', 'lf', 'control', 'extend', 'zwj', 'regional_indicator', 'prepend',
+    'spacing_mark', 'l', 'v', 't', 'lv', 'lvt', 'extended_pictographic',
+]
+
+# Must match the flags in btr::unicode_detail::norm_props
+NFD_QC_NO = 1
+NFC_QC_MAYBE = 2
+NFC_QC_NO = 4
+
+S_BASE, L_BASE, V_BASE, T_BASE = 0xAC00, 0x1100, 0x1161, 0x11A7
+S_COUNT, T_COUNT = 11172, 28
+
+
+def in_ranges(cp, ranges):
+    return any(first <= cp <= last for first, last in ranges)
+
+
+def canonical_decomposition(cp):
+    """Get the single-level canonical decomposition of a codepoint, or None"""
+    decomp = unicodedata.decomposition(chr(cp))
+    if not decomp or decomp.startswith('<'):
+        return None
+    return [int(part, 16) for part in decomp.split()]
+
+
+def grapheme_break(cp):
+    if cp == 0x0D:
+        return 'cr'
+    if cp == 0x0A:
+        return 'lf'
+    if cp == 0x200D:
+        return 'zwj'
+    if 0x1F1E6 <= cp <= 0x1F1FF:
+        return 'regional_indicator'
+    c = chr(cp)
+    cat = unicodedata.category(c)
+    if in_ranges(cp, PREPENDED_CONCATENATION_MARK) or in_ranges(cp, PREPEND_INDIC):
+        return 'prepend'
+    # Grapheme_Extend takes priority over Control for the format characters in the TAG block
+    if cat in ('Mn', 'Me') or in_ranges(cp, OTHER_GRAPHEME_EXTEND) or 0x1F3FB <= cp <= 0x1F3FF:
+        return 'extend'
+    if cat in ('Zl', 'Zp', 'Cc', 'Cf') or (cat == 'Cn'
+                                           and in_ranges(cp, UNASSIGNED_DEFAULT_IGNORABLE)):
+        return 'control'
+    if in_ranges(cp, SPACING_MARK_ADDITIONS) or (cat == 'Mc'
+                                                 and not in_ranges(cp, SPACING_MARK_EXCEPTIONS)):
+        return 'spacing_mark'
+    if 0x1100 <= cp <= 0x115F or 0xA960 <= cp <= 0xA97C:
+        return 'l'
+    if 0x1160 <= cp <= 0x11A7 or 0xD7B0 <= cp <= 0xD7C6:
+        return 'v'
+    if 0x11A8 <= cp <= 0x11FF or 0xD7CB <= cp <= 0xD7FB:
+        return 't'
+    if S_BASE <= cp < S_BASE + S_COUNT:
+        return 'lv' if (cp - S_BASE) % T_COUNT == 0 else 'lvt'
+    if in_ranges(cp, EXTENDED_PICTOGRAPHIC):
+        return 'extended_pictographic'
+    return 'other'
+
+
+def build_compositions():
+    """Build the list of [first, second, composite] for each primary composite"""
+    comps = []
+    for cp in range(0x80, 0x110000):
+        decomp = canonical_decomposition(cp)
+        if decomp is None or len(decomp) != 2:
+            continue
+        # Excluded composites do not survive a round trip through NFC
+        if unicodedata.normalize('NFC', chr(cp)) != chr(cp):
+            continue
+        comps.append((decomp[0], decomp[1], cp))
+    comps.sort()
+    return comps
+
+
+def build_props(comps):
+    """Build a list of [first, ccc, flags, gcb] runs, which each extend to the next run"""
+    second_of_pair = {second for _, second, _ in comps}
+    runs = []
+    for cp in range(0x110000):
+        if 0xD800 <= cp < 0xE000:
+            props = (0, 0, GCB_NAMES.index('control'))
+        else:
+            c = chr(cp)
+            flags = 0
+            if unicodedata.normalize('NFD', c) != c:
+                flags |= NFD_QC_NO
+            if unicodedata.normalize('NFC', c) != c:
+                flags |= NFC_QC_NO
+            elif cp in second_of_pair or V_BASE <= cp < V_BASE + 21 or T_BASE < cp < T_BASE + 28:
+                flags |= NFC_QC_MAYBE
+            props = (unicodedata.combining(c), flags, GCB_NAMES.index(grapheme_break(cp)))
+        if not runs or runs[-1][1:] != props:
+            runs.append((cp, ) + props)
+    return runs
+
+
+def build_decompositions():
+    """Build the list of [codepoint, first, second] single-level canonical decompositions"""
+    ret = []
+    for cp in range(0x80, 0x110000):
+        if S_BASE <= cp < S_BASE + S_COUNT:
+            # Hangul syllables are decomposed algorithmically
+            continue
+        decomp = canonical_decomposition(cp)
+        if decomp is None:
+            continue
+        ret.append((cp, decomp[0], decomp[1] if len(decomp) == 2 else 0))
+    return ret
+
+
+def main():
+    comps = build_compositions()
+    props = build_props(comps)
+    decomps = build_decompositions()
+    out = sys.stdout
+    out.write(f'''// This file is generated by tools/gen-unicode-tables.py. Do not edit.
+// Unicode version {unicodedata.unidata_version}
+
+#include "./unicode.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+
+using namespace btr::unicode_detail;
+
+namespace {{
+
+struct prop_run {{
+    char32_t     first;
+    std::uint8_t ccc;
+    std::uint8_t flags;
+    std::uint8_t gcb;
+}};
+
+struct decomposition {{
+    char32_t codepoint;
+    char32_t first;
+    char32_t second;
+}};
+
+struct composition {{
+    char32_t first;
+    char32_t second;
+    char32_t composite;
+}};
+
+constexpr prop_run prop_runs[] = {{
+''')
+    for first, ccc, flags, gcb in props:
+        out.write(f'    {{0x{first:04X}, {ccc}, {flags}, {gcb}}},\n')
+    out.write('''};
+
+constexpr decomposition decompositions[] = {
+''')
+    for cp, first, second in decomps:
+        out.write(f'    {{0x{cp:04X}, 0x{first:04X}, 0x{second:04X}}},\n')
+    out.write('''};
+
+constexpr composition compositions[] = {
+''')
+    for first, second, composite in comps:
+        out.write(f'    {{0x{first:04X}, 0x{second:04X}, 0x{composite:04X}}},\n')
+    out.write('''};
+
+const prop_run& find_run(char32_t c) noexcept {
+    auto it = std::upper_bound(std::begin(prop_runs),
+                               std::end(prop_runs),
+                               c,
+                               [](char32_t cp, const prop_run& run) { return cp < run.first; });
+    return *std::prev(it);
+}
+
+}  // namespace
+
+norm_props btr::unicode_detail::get_norm_props(char32_t c) noexcept {
+    if (c > 0x10'ffff) {
+        return {};
+    }
+    auto& run = find_run(c);
+    return {run.ccc, run.flags};
+}
+
+grapheme_break btr::unicode_detail::get_grapheme_break(char32_t c) noexcept {
+    if (c > 0x10'ffff) {
+        return grapheme_break::other;
+    }
+    return static_cast<grapheme_break>(find_run(c).gcb);
+}
+
+std::size_t btr::unicode_detail::canonical_decomposition(char32_t c, char32_t* out) noexcept {
+    auto it = std::lower_bound(std::begin(decompositions),
+                               std::end(decompositions),
+                               c,
+                               [](const decomposition& dec, char32_t cp) {
+                                   return dec.codepoint < cp;
+                               });
+    if (it == std::end(decompositions) || it->codepoint != c) {
+        return 0;
+    }
+    out[0] = it->first;
+    out[1] = it->second;
+    return it->second ? 2 : 1;
+}
+
+char32_t btr::unicode_detail::canonical_composition(char32_t first, char32_t second) noexcept {
+    auto it = std::lower_bound(std::begin(compositions),
+                               std::end(compositions),
+                               std::pair{first, second},
+                               [](const composition& comp, std::pair<char32_t, char32_t> key) {
+                                   return std::pair{comp.first, comp.second} < key;
+                               });
+    if (it == std::end(compositions) || it->first != first || it->second != second) {
+        return 0;
+    }
+    return it->composite;
+}
+''')
+
+
+if __name__ == '__main__':
+    main()